@@ -0,0 +1,79 @@
+#include "font_pack.h"
+
+#include <string.h>
+
+typedef struct {
+    const uint8_t* data;
+    uint32_t size;
+    uint32_t pos;  // 下一个要读入的字节
+    uint32_t acc;
+    int bits;      // acc 中剩余的位数
+} bit_reader_t;
+
+// 高位在前读取 count (<= 16) 位，数据不足时返回 -1
+static int read_bits(bit_reader_t* r, int count) {
+    while (r->bits < count) {
+        if (r->pos >= r->size) {
+            return -1;
+        }
+        r->acc = (r->acc << 8) | r->data[r->pos++];
+        r->bits += 8;
+    }
+    r->bits -= count;
+    return (r->acc >> r->bits) & ((1u << count) - 1);
+}
+
+bool font_pack_is_packed(const EpdFont* font) {
+    return font->compressed && memcmp(font->bitmap, FONT_PACK_MAGIC, 4) == 0;
+}
+
+const EpdGlyph* font_pack_lookup(const font_pack_t* pack, uint32_t codepoint) {
+    uint32_t page = codepoint >> FONT_PACK_PAGE_BITS;
+    if (page >= pack->page_count || pack->page_map[page] >= pack->pages_used) {
+        return NULL;
+    }
+    uint16_t index = pack->pages[((uint32_t)pack->page_map[page] << FONT_PACK_PAGE_BITS) |
+                                 (codepoint & ((1u << FONT_PACK_PAGE_BITS) - 1))];
+    return index >= pack->glyph_count ? NULL : &pack->font.glyph[index]; // 包括 FONT_PACK_NONE
+}
+
+const EpdGlyph* font_pack_fallback(const font_pack_t* pack) {
+    return pack->fallback >= pack->glyph_count ? NULL : &pack->font.glyph[pack->fallback];
+}
+
+const uint8_t* font_pack_mono(const font_pack_t* pack, const EpdGlyph* glyph) {
+    if (pack->mono == NULL) {
+        return NULL;
+    }
+    return pack->mono + pack->mono_offsets[glyph - pack->font.glyph];
+}
+
+bool font_pack_decode(const uint8_t* src, uint32_t src_size, uint8_t* out, uint32_t out_size) {
+    bit_reader_t r = {src, src_size, 0, 0, 0};
+    uint32_t n = 0;
+    while (n < out_size) {
+        int tag = read_bits(&r, 1);
+        if (tag < 0) {
+            return false;
+        }
+        if (tag) {
+            int literal = read_bits(&r, 8);
+            if (literal < 0) {
+                return false;
+            }
+            out[n++] = literal;
+            continue;
+        }
+        int index = read_bits(&r, FONT_PACK_WINDOW_BITS);
+        int count = read_bits(&r, FONT_PACK_LOOKAHEAD_BITS);
+        if (index < 0 || count < 0 || (uint32_t)index + 1 > n || n + count + 1 > out_size) {
+            return false;
+        }
+        // 距离可能小于长度，逐字节复制
+        const uint8_t* from = out + n - index - 1;
+        for (int i = 0; i <= count; i++) {
+            out[n++] = from[i];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+# 构建时用 font_pack.py 把 epdiy 字体头文件转换成字体包，生成的 <名称>_pack.h 放在构建目录的 font_packs/<目标> 下，
+# 同一目录中的多个目标各自生成
+set(FONT_PACK_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(FONT_PACK_HOT_RANGES "0x20-0x7E" CACHE STRING "字体包中不压缩的码点范围，如 0x20-0x7E,0xB0")
+set(FONT_PACK_KEEP_RANGES "0x20-0x7E" CACHE STRING "字体子集中总是保留的码点范围")
+option(FONT_PACK_SUBSET "按 SUBSET_SOURCES 中的字符串裁剪字体" ON)
+
+# font_pack_add(<目标> <python> [MONO] FONTS <字体头文件>... [SUBSET_SOURCES <C 源文件>...])
+# 给出 SUBSET_SOURCES 时字体只保留这些文件的字符串常量中用到的字符和 FONT_PACK_KEEP_RANGES；
+# MONO 同时生成1bpp变体，TEXT_DRAW_MONO 绘制时使用
+function(font_pack_add target python)
+    cmake_parse_arguments(PACK "MONO" "" "FONTS;SUBSET_SOURCES" ${ARGN})
+    set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/font_packs/${target})
+    set(extra_args)
+    if(FONT_PACK_SUBSET AND PACK_SUBSET_SOURCES)
+        set(extra_args --subset ${PACK_SUBSET_SOURCES} --keep ${FONT_PACK_KEEP_RANGES})
+    endif()
+    if(PACK_MONO)
+        list(APPEND extra_args --mono)
+    endif()
+    foreach(source ${PACK_FONTS})
+        get_filename_component(name ${source} NAME_WE)
+        set(output ${out_dir}/${name}_pack.h)
+        add_custom_command(OUTPUT ${output}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${out_dir}
+            COMMAND ${python} ${FONT_PACK_DIR}/font_pack.py ${source} ${output} --hot ${FONT_PACK_HOT_RANGES}
+                    ${extra_args}
+            DEPENDS ${source} ${FONT_PACK_DIR}/font_pack.py ${PACK_SUBSET_SOURCES}
+            COMMENT "Generating font pack ${name}_pack.h for ${target}"
+            VERBATIM)
+        target_sources(${target} PRIVATE ${output})
+    endforeach()
+    target_include_directories(${target} PRIVATE ${out_dir} ${FONT_PACK_DIR})
+endfunction()
+
+# font_sdf_add(<目标> <python> FONTS <字体头文件>... [SUBSET_SOURCES <C 源文件>...])
+# 用 font_sdf.py 把字体转换成距离场字体资源 <名称>_sdf.h，设备上用 font_sdf_get 按需要的行高创建实例
+function(font_sdf_add target python)
+    cmake_parse_arguments(SDF "" "" "FONTS;SUBSET_SOURCES" ${ARGN})
+    set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/font_packs/${target})
+    set(subset_args)
+    if(FONT_PACK_SUBSET AND SDF_SUBSET_SOURCES)
+        set(subset_args --subset ${SDF_SUBSET_SOURCES} --keep ${FONT_PACK_KEEP_RANGES})
+    endif()
+    foreach(source ${SDF_FONTS})
+        get_filename_component(name ${source} NAME_WE)
+        set(output ${out_dir}/${name}_sdf.h)
+        add_custom_command(OUTPUT ${output}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${out_dir}
+            COMMAND ${python} ${FONT_PACK_DIR}/font_sdf.py ${source} ${output} ${subset_args}
+            DEPENDS ${source} ${FONT_PACK_DIR}/font_sdf.py ${FONT_PACK_DIR}/font_pack.py ${SDF_SUBSET_SOURCES}
+            COMMENT "Generating SDF font ${name}_sdf.h for ${target}"
+            VERBATIM)
+        target_sources(${target} PRIVATE ${output})
+    endforeach()
+    target_include_directories(${target} PRIVATE ${out_dir} ${FONT_PACK_DIR})
+endfunction()
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 字体包：font_pack.py 在构建时生成的 EpdFont，字段与 epdiy 字体相同。位图数据以 FONT_PACK_MAGIC 开头，
+// compressed_size 为0的字形（热区和压缩后不更小的字形）直接存放4bpp位图，其余是 heatshrink 格式的 LZSS 数据
+#define FONT_PACK_MAGIC          "EFP1"
+#define FONT_PACK_WINDOW_BITS    8
+#define FONT_PACK_LOOKAHEAD_BITS 4
+#define FONT_PACK_PAGE_BITS      8
+#define FONT_PACK_NONE           0xFFFF
+
+// 生成的头文件定义 <名称>Pack，并把 <名称> 定义为其中的 font，因此 &<名称> 可以当作普通 EpdFont 使用。
+// 码点到字形的两级索引：page_map[码点 >> 8] 是页号，pages[页号 * 256 + 低8位] 是字形序号
+typedef struct {
+    EpdFont font;  // 必须是第一个成员
+    uint32_t page_count;
+    const uint16_t* page_map;
+    const uint16_t* pages;
+    uint32_t pages_used;  // pages 中的页数
+    uint32_t glyph_count;
+    uint16_t fallback;    // 缺字时代替的字形序号，没有时为 FONT_PACK_NONE
+    const uint8_t* mono;  // font_pack.py --mono 生成的1bpp变体，没有时为 NULL
+    const uint32_t* mono_offsets;
+} font_pack_t;
+
+// font 是否由 font_pack_t 生成（位图数据以 FONT_PACK_MAGIC 开头）
+bool font_pack_is_packed(const EpdFont* font);
+
+// 两次查表得到码点的字形，字体中没有时返回 NULL
+const EpdGlyph* font_pack_lookup(const font_pack_t* pack, uint32_t codepoint);
+
+// 缺字时代替的字形，没有时返回 NULL
+const EpdGlyph* font_pack_fallback(const font_pack_t* pack);
+
+// 字形的1bpp变体：每行 (width + 7) / 8 字节，低位是左边的像素，直接指向字体数据。没有时返回 NULL
+const uint8_t* font_pack_mono(const font_pack_t* pack, const EpdGlyph* glyph);
+
+// 解压一个字形的位图，数据损坏或长度不符时返回 false
+bool font_pack_decode(const uint8_t* src, uint32_t src_size, uint8_t* out, uint32_t out_size);
@@ -0,0 +1,363 @@
+import argparse
+import os
+import re
+import sys
+import zlib
+
+# 字体包生成器：读取 epdiy fontconvert.py 生成的字体头文件，输出字段相同的 EpdFont，
+# 其中常用码点（热区）的位图不压缩，其余字形用 heatshrink 格式的 LZSS 单独压缩，
+# 另外生成按码点高位分页的两级索引。指定 --subset 时只保留源文件字符串中用到的字符和 --keep 中的字符。
+# 构建时由 font_pack.cmake 调用，设备端见 font_pack.c
+
+# 与 font_pack.h 保持一致
+FONT_PACK_MAGIC = b'EFP1'
+FONT_PACK_WINDOW_BITS = 8
+FONT_PACK_LOOKAHEAD_BITS = 4
+FONT_PACK_PAGE_BITS = 8
+FONT_PACK_NONE = 0xFFFF
+
+DEFAULT_HOT_RANGES = '0x20-0x7E'
+DEFAULT_FALLBACK = '0xFFFD,0x3F'
+MONO_THRESHOLD = 8  # 1bpp 变体中覆盖率不低于它的像素为黑
+MONO_FAINT = 4      # 细笔画保留的最低覆盖率
+DEFAULT_KEEP = '0x20-0x7E'  # 子集中总是保留的字符，格式化输出的数字、十六进制和名称都在这里
+
+
+def parse_font(path):
+    """解析字体头文件，返回 (名称, 位图数据, 字形列表, 码点区间, EpdFont 其余字段)"""
+    with open(path, encoding='utf-8') as f:
+        text = f.read()
+    m = re.search(r'const\s+EpdFont\s+(\w+)\s*=\s*\{(.*?)\};', text, re.S)
+    if m is None:
+        raise ValueError(f'{path}: 找不到 EpdFont 定义')
+    name = m.group(1)
+    fields = [x.strip() for x in m.group(2).split(',') if x.strip()]
+    compressed = fields[4] not in ('0', 'false')
+    metrics = fields[5:]  # advance_y, ascender, descender
+
+    bitmap = re.search(r'Bitmaps\[\d*\]\s*=\s*\{(.*?)\};', text, re.S).group(1)
+    data = bytes(int(x, 16) for x in re.findall(r'0x([0-9A-Fa-f]{2})', bitmap))
+
+    glyph_block = re.search(r'Glyphs\[\]\s*=\s*\{(.*?)\n\};', text, re.S).group(1)
+    glyphs = [tuple(int(v) for v in g) for g in
+              re.findall(r'\{\s*' + r',\s*'.join([r'(-?\d+)'] * 7) + r'\s*\}', glyph_block)]
+
+    interval_block = re.search(r'Intervals\[\]\s*=\s*\{(.*?)\};', text, re.S).group(1)
+    intervals = [tuple(int(v, 16) for v in i) for i in
+                 re.findall(r'\{\s*0x([0-9A-Fa-f]+),\s*0x([0-9A-Fa-f]+),\s*0x([0-9A-Fa-f]+)\s*\}', interval_block)]
+
+    bitmaps = []
+    for width, height, _, _, _, size, offset in glyphs:
+        raw_size = (width + 1) // 2 * height
+        chunk = data[offset:offset + (size if compressed else raw_size)]
+        raw = zlib.decompress(chunk) if compressed else chunk
+        if len(raw) != raw_size:
+            raise ValueError(f'{path}: 字形位图大小不符 (偏移 {offset})')
+        bitmaps.append(raw)
+    return name, bitmaps, glyphs, intervals, metrics
+
+
+def parse_ranges(spec):
+    ranges = []
+    for part in spec.split(','):
+        first, _, last = part.strip().partition('-')
+        ranges.append((int(first, 0), int(last or first, 0)))
+    return ranges
+
+
+def source_codepoints(path):
+    """C 源文件中字符串和字符常量用到的码点，跳过注释"""
+    with open(path, 'rb') as f:
+        src = f.read()
+    escapes = {ord('n'): 10, ord('t'): 9, ord('r'): 13, ord('0'): 0}
+    found = set()
+    i = 0
+    while i < len(src):
+        if src.startswith(b'//', i):
+            i = src.find(b'\n', i)
+            i = len(src) if i < 0 else i
+        elif src.startswith(b'/*', i):
+            i = src.find(b'*/', i + 2)
+            i = len(src) if i < 0 else i + 2
+        elif src[i] in b'"\'':
+            quote, i, literal = src[i], i + 1, bytearray()
+            while i < len(src) and src[i] != quote:
+                if src[i] == ord('\\') and i + 1 < len(src):
+                    c = src[i + 1]
+                    if c == ord('x'):
+                        m = re.match(rb'[0-9A-Fa-f]{1,2}', src[i + 2:])
+                        literal.append(int(m.group(0), 16) if m else 0)
+                        i += 2 + (len(m.group(0)) if m else 0)
+                        continue
+                    literal.append(escapes.get(c, c))
+                    i += 2
+                else:
+                    literal.append(src[i])
+                    i += 1
+            found.update(ord(ch) for ch in literal.decode('utf-8', errors='ignore'))
+            i += 1
+        else:
+            i += 1
+    return found
+
+
+def subset_font(bitmaps, glyphs, intervals, keep):
+    """只保留 keep 中的码点，返回新的 (位图, 字形, 码点区间)，字形按码点排序"""
+    kept = sorted((cp, index) for index, cp in glyph_codepoints(intervals) if cp in keep)
+    out_bitmaps = [bitmaps[index] for _, index in kept]
+    out_glyphs = [glyphs[index] for _, index in kept]
+    out_intervals = []
+    for i, (cp, _) in enumerate(kept):
+        if out_intervals and out_intervals[-1][1] == cp - 1:
+            out_intervals[-1][1] = cp
+        else:
+            out_intervals.append([cp, cp, i])
+    return out_bitmaps, out_glyphs, [tuple(iv) for iv in out_intervals]
+
+
+def flash_size(data, glyph_count, interval_count, index_entries=0):
+    """位图、字形表（EpdGlyph 16字节）、区间表和索引占用的 flash"""
+    return len(data) + glyph_count * 16 + interval_count * 12 + index_entries * 2
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.bits = 0
+
+    def write(self, value, count):
+        for i in range(count - 1, -1, -1):
+            self.acc = (self.acc << 1) | ((value >> i) & 1)
+            self.bits += 1
+            if self.bits == 8:
+                self.out.append(self.acc)
+                self.acc = 0
+                self.bits = 0
+
+    def finish(self):
+        if self.bits:
+            self.out.append(self.acc << (8 - self.bits))
+        return bytes(self.out)
+
+
+def lzss_compress(src):
+    """heatshrink 位流：1 + 8位字面量，或 0 + (距离-1) + (长度-1)，高位在前"""
+    window = 1 << FONT_PACK_WINDOW_BITS
+    max_len = 1 << FONT_PACK_LOOKAHEAD_BITS
+    ref_bits = 1 + FONT_PACK_WINDOW_BITS + FONT_PACK_LOOKAHEAD_BITS
+    writer = BitWriter()
+    positions = {}  # 两字节前缀 -> 出现位置
+    i = 0
+    while i < len(src):
+        best_len, best_pos = 0, 0
+        for j in reversed(positions.get(src[i:i + 2], ())):
+            if i - j > window:
+                break
+            n = 0
+            while n < max_len and i + n < len(src) and src[j + n] == src[i + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_pos = n, j
+                if n == max_len:
+                    break
+        step = best_len if best_len * 9 > ref_bits else 1
+        if step > 1:
+            writer.write(0, 1)
+            writer.write(i - best_pos - 1, FONT_PACK_WINDOW_BITS)
+            writer.write(best_len - 1, FONT_PACK_LOOKAHEAD_BITS)
+        else:
+            writer.write(1, 1)
+            writer.write(src[i], 8)
+        for k in range(i, i + step):
+            positions.setdefault(src[k:k + 2], []).append(k)
+        i += step
+    return writer.finish()
+
+
+def glyph_codepoints(intervals):
+    for first, last, offset in intervals:
+        for cp in range(first, last + 1):
+            yield offset + cp - first, cp
+
+
+def build_pack(bitmaps, glyphs, intervals, hot_ranges):
+    """热区字形的位图在前、不压缩；其余字形压缩，压缩后不更小时同样原样存放（compressed_size 为0）"""
+    codepoint = dict(glyph_codepoints(intervals))
+    is_hot = [any(a <= codepoint.get(i, -1) <= b for a, b in hot_ranges) for i in range(len(glyphs))]
+    data = bytearray(FONT_PACK_MAGIC)
+    out_glyphs = [None] * len(glyphs)
+    order = [i for i in range(len(glyphs)) if is_hot[i]] + [i for i in range(len(glyphs)) if not is_hot[i]]
+    for i in order:
+        width, height, advance_x, left, top, _, _ = glyphs[i]
+        stored, size = bitmaps[i], 0
+        if not is_hot[i] and bitmaps[i]:
+            packed = lzss_compress(bitmaps[i])
+            if len(packed) < len(bitmaps[i]):
+                stored, size = packed, len(packed)
+        out_glyphs[i] = (width, height, advance_x, left, top, size, len(data))
+        data.extend(stored)
+    hot_bytes = sum(len(bitmaps[i]) for i in range(len(glyphs)) if is_hot[i])
+    return bytes(data), out_glyphs, hot_bytes
+
+
+def build_index(glyph_count, intervals):
+    """两级索引：page_map[码点 >> 8] 是页号，pages[页号 * 256 + 低8位] 是字形序号"""
+    if glyph_count >= FONT_PACK_NONE:
+        raise ValueError(f'字形数 {glyph_count} 超出索引范围')
+    page_size = 1 << FONT_PACK_PAGE_BITS
+    by_page = {}
+    for index, cp in glyph_codepoints(intervals):
+        page = by_page.setdefault(cp >> FONT_PACK_PAGE_BITS, [FONT_PACK_NONE] * page_size)
+        page[cp & (page_size - 1)] = index
+    page_map = [FONT_PACK_NONE] * (max(by_page) + 1 if by_page else 0)
+    pages = []
+    for number, page in sorted(by_page.items()):
+        page_map[number] = len(pages) // page_size
+        pages.extend(page)
+    return page_map, pages
+
+
+def mono_bitmap(bitmap, width, height):
+    """4bpp 位图二值化成1bpp：每行 (width + 7) / 8 字节，低位是左边的像素。
+    覆盖率过半的像素为黑；一行或一列中整段都没有过半、也不紧挨黑像素的细笔画，保留其中最深的一点，
+    避免阈值把细横线和细竖线整条去掉"""
+    byte_width = (width + 1) // 2
+    coverage = [[(bitmap[y * byte_width + x // 2] >> (4 * (x & 1))) & 0x0F for x in range(width)]
+                for y in range(height)]
+    ink = [[c >= MONO_THRESHOLD for c in row] for row in coverage]
+
+    def near_ink(x, y):
+        return any(0 <= x + dx < width and 0 <= y + dy < height and ink[y + dy][x + dx]
+                   for dx, dy in ((1, 0), (-1, 0), (0, 1), (0, -1)))
+
+    def keep_faint(line):
+        # line 为一行或一列的 (x, y) 坐标
+        run = []
+        for x, y in line + [(None, None)]:
+            if x is not None and coverage[y][x] > 0:
+                run.append((x, y))
+                continue
+            if run and not any(ink[ry][rx] for rx, ry in run):
+                px, py = max(run, key=lambda p: coverage[p[1]][p[0]])
+                if coverage[py][px] >= MONO_FAINT and not near_ink(px, py):
+                    extra.add((px, py))
+            run = []
+
+    extra = set()
+    for y in range(height):
+        keep_faint([(x, y) for x in range(width)])
+    for x in range(width):
+        keep_faint([(x, y) for y in range(height)])
+    for x, y in extra:
+        ink[y][x] = True
+
+    out = bytearray()
+    for row in ink:
+        for i in range(0, width, 8):
+            out.append(sum(1 << j for j, on in enumerate(row[i:i + 8]) if on))
+    return bytes(out)
+
+
+def build_mono(bitmaps, glyphs):
+    """按字形顺序排列的1bpp变体和每个字形的偏移"""
+    data = bytearray()
+    offsets = []
+    for bitmap, (width, height, *_) in zip(bitmaps, glyphs):
+        offsets.append(len(data))
+        data.extend(mono_bitmap(bitmap, width, height))
+    return bytes(data), offsets
+
+
+def find_fallback(intervals, spec):
+    """缺字时代替的字形：spec 中第一个字体里存在的码点"""
+    index_of = {cp: index for index, cp in glyph_codepoints(intervals)}
+    for first, _ in parse_ranges(spec):
+        if first in index_of:
+            return index_of[first]
+    return FONT_PACK_NONE
+
+
+def append_array(lines, decl, values, fmt):
+    lines.append(f'{decl} = {{')
+    for i in range(0, len(values), 16):
+        lines.append('    ' + ' '.join(fmt.format(v) + ',' for v in values[i:i + 16]))
+    lines.append('};')
+
+
+def write_header(path, source, name, data, glyphs, intervals, metrics, hot_spec, page_map, pages, fallback,
+                 mono=None):
+    lines = [
+        '#pragma once',
+        f'// 由 font_pack.py 从 {os.path.basename(source)} 生成，不要手动修改。热区 {hot_spec} 不压缩',
+        '#include "epdiy.h"',
+        '#include "font_pack.h"',
+    ]
+    append_array(lines, f'const uint8_t {name}Bitmaps[{len(data)}]', data, '0x{:02X}')
+    lines.append(f'const EpdGlyph {name}Glyphs[] = {{')
+    for g in glyphs:
+        lines.append('    {' + ', '.join(str(v) for v in g) + '},')
+    lines.append('};')
+    lines.append(f'const EpdUnicodeInterval {name}Intervals[] = {{')
+    for first, last, offset in intervals:
+        lines.append(f'    {{0x{first:X}, 0x{last:X}, 0x{offset:X}}},')
+    lines.append('};')
+    append_array(lines, f'const uint16_t {name}PageMap[{len(page_map)}]', page_map, '0x{:04X}')
+    append_array(lines, f'const uint16_t {name}Pages[{len(pages)}]', pages, '0x{:04X}')
+    if mono is not None:
+        append_array(lines, f'const uint8_t {name}Mono[{max(len(mono[0]), 1)}]', mono[0] or b'\0', '0x{:02X}')
+        append_array(lines, f'const uint32_t {name}MonoOffsets[{len(mono[1])}]', mono[1], '{}')
+    lines.append(f'const font_pack_t {name}Pack = {{')
+    lines.append(f'    {{{name}Bitmaps, {name}Glyphs, {name}Intervals, {len(intervals)}, 1, {", ".join(metrics)}}},')
+    lines.append(f'    {len(page_map)}, {name}PageMap, {name}Pages, {len(pages) >> FONT_PACK_PAGE_BITS}, {len(glyphs)},')
+    lines.append(f'    0x{fallback:04X}, ' + (f'{name}Mono, {name}MonoOffsets,' if mono is not None else 'NULL, NULL,'))
+    lines.append('};')
+    lines.append(f'#define {name} ({name}Pack.font)')
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='把 epdiy 字体头文件转换为热区不压缩、其余 LZSS 压缩的字体包')
+    parser.add_argument('input', help='fontconvert.py 生成的字体头文件')
+    parser.add_argument('output', help='输出的字体包头文件')
+    parser.add_argument('--hot', default=DEFAULT_HOT_RANGES, help='不压缩的码点范围，如 0x20-0x7E,0xB0')
+    parser.add_argument('--fallback', default=DEFAULT_FALLBACK, help='缺字时代替的码点，依次取字体中第一个存在的')
+    parser.add_argument('--subset', nargs='+', metavar='SOURCE', help='只保留这些 C 源文件的字符串常量中用到的字符')
+    parser.add_argument('--keep', default=DEFAULT_KEEP, help='子集中总是保留的码点范围')
+    parser.add_argument('--mono', action='store_true', help='同时生成1bpp变体，用于黑白快速刷新')
+    args = parser.parse_args()
+
+    name, bitmaps, glyphs, intervals, metrics = parse_font(args.input)
+    with open(args.input, encoding='utf-8') as f:
+        source_data = re.search(r'Bitmaps\[(\d+)\]', f.read())
+    original = flash_size(b'', len(glyphs), len(intervals)) + int(source_data.group(1))
+    total = len(glyphs)
+    if args.subset:
+        keep = set()
+        for first, last in parse_ranges(args.keep):
+            keep.update(range(first, last + 1))
+        for path in args.subset:
+            keep.update(source_codepoints(path))
+        fallback = find_fallback(intervals, args.fallback)
+        keep.update(cp for index, cp in glyph_codepoints(intervals) if index == fallback)
+        bitmaps, glyphs, intervals = subset_font(bitmaps, glyphs, intervals, keep)
+        missing = sorted(cp for cp in keep - {cp for _, cp in glyph_codepoints(intervals)} if cp >= 0x20)
+        if missing:
+            print(f'{name}: 字体中没有 ' + ' '.join(f'U+{cp:04X}' for cp in missing), file=sys.stderr)
+
+    data, out_glyphs, hot_bytes = build_pack(bitmaps, glyphs, intervals, parse_ranges(args.hot))
+    page_map, pages = build_index(len(glyphs), intervals)
+    mono = build_mono(bitmaps, glyphs) if args.mono else None
+    write_header(args.output, args.input, name, data, out_glyphs, intervals, metrics, args.hot,
+                 page_map, pages, find_fallback(intervals, args.fallback), mono)
+    packed = flash_size(data, len(glyphs), len(intervals), len(page_map) + len(pages))
+    if mono is not None:
+        print(f'{name}: 1bpp 变体 {len(mono[0]) + 4 * len(mono[1])} 字节，4bpp 位图 '
+              f'{sum(len(b) for b in bitmaps)} 字节', file=sys.stderr)
+    print(f'{name}: {len(glyphs)}/{total} 个字形，位图 {len(data)} 字节（热区 {hot_bytes} 字节），'
+          f'共 {packed} 字节，原字体 {original} 字节，节省 {original - packed} 字节', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
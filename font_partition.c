@@ -0,0 +1,132 @@
+#include "font_partition.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "font_pack.h"
+
+static const char* TAG = "font_partition";
+
+static const uint8_t* image = NULL;
+static esp_partition_mmap_handle_t mmap_handle;
+static font_pack_t packs[FONT_PARTITION_FONTS];
+static char names[FONT_PARTITION_FONTS][FONT_PARTITION_NAME_MAX];
+static int font_count = 0;
+
+// 段 [offset, offset + size) 是否在记录内且4字节对齐
+static bool section_ok(const font_partition_entry_t* entry, uint32_t offset, uint64_t size) {
+    return offset % 4 == 0 && offset <= entry->size && size <= entry->size - offset;
+}
+
+static bool load_font(const font_partition_entry_t* entry, font_pack_t* pack) {
+    const uint8_t* base = image + entry->offset;
+    const font_partition_font_t* font = (const font_partition_font_t*)base;
+    if (entry->size < sizeof(*font) ||
+        !section_ok(entry, font->glyphs, (uint64_t)font->glyph_count * sizeof(font_partition_glyph_t)) ||
+        !section_ok(entry, font->intervals, (uint64_t)font->interval_count * sizeof(EpdUnicodeInterval)) ||
+        !section_ok(entry, font->page_map, (uint64_t)font->page_count * sizeof(uint16_t)) ||
+        font->pages > font->bitmap || !section_ok(entry, font->pages, font->bitmap - font->pages) ||
+        (font->bitmap - font->pages) % (sizeof(uint16_t) << FONT_PACK_PAGE_BITS) != 0 ||
+        !section_ok(entry, font->bitmap, font->bitmap_size) ||
+        font->bitmap_size < 4 || memcmp(base + font->bitmap, FONT_PACK_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    // 字形表的字段宽度与 EpdGlyph 不一定相同，转换一次；其它部分直接使用映射的数据
+    EpdGlyph* glyphs = heap_caps_malloc(font->glyph_count * sizeof(EpdGlyph), MALLOC_CAP_SPIRAM);
+    if (glyphs == NULL) {
+        return false;
+    }
+    const font_partition_glyph_t* src = (const font_partition_glyph_t*)(base + font->glyphs);
+    for (uint32_t i = 0; i < font->glyph_count; i++) {
+        const font_partition_glyph_t* g = &src[i];
+        uint64_t size = g->compressed_size ? g->compressed_size : (uint64_t)(g->width + 1) / 2 * g->height;
+        if (g->data_offset + size > font->bitmap_size) {
+            glyphs[i] = (EpdGlyph){.advance_x = g->advance_x}; // 数据越界的字形不画
+            continue;
+        }
+        glyphs[i] = (EpdGlyph){
+            .width = g->width,
+            .height = g->height,
+            .advance_x = g->advance_x,
+            .left = g->left,
+            .top = g->top,
+            .compressed_size = g->compressed_size,
+            .data_offset = g->data_offset,
+        };
+    }
+
+    // 索引中的页号和字形序号在 font_pack_lookup 中检查，越界的当作缺字
+    pack->font = (EpdFont){
+        .bitmap = base + font->bitmap,
+        .glyph = glyphs,
+        .intervals = (const EpdUnicodeInterval*)(base + font->intervals),
+        .interval_count = font->interval_count,
+        .compressed = true,
+        .advance_y = font->advance_y,
+        .ascender = font->ascender,
+        .descender = font->descender,
+    };
+    pack->page_count = font->page_count;
+    pack->page_map = (const uint16_t*)(base + font->page_map);
+    pack->pages = (const uint16_t*)(base + font->pages);
+    pack->pages_used = (font->bitmap - font->pages) / (sizeof(uint16_t) << FONT_PACK_PAGE_BITS); // 位图紧跟在页之后
+    pack->glyph_count = font->glyph_count;
+    pack->fallback = font->fallback;
+    pack->mono = NULL; // 分区字体没有1bpp变体，黑白绘制时按阈值二值化
+    return true;
+}
+
+int font_partition_mount(void) {
+    if (image != NULL) {
+        return font_count;
+    }
+    const esp_partition_t* part =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, FONT_PARTITION_SUBTYPE, FONT_PARTITION_LABEL);
+    if (part == NULL) {
+        ESP_LOGI(TAG, "no %s partition", FONT_PARTITION_LABEL);
+        return 0;
+    }
+    font_partition_header_t header;
+    if (esp_partition_read(part, 0, &header, sizeof(header)) != ESP_OK ||
+        memcmp(header.magic, FONT_PARTITION_MAGIC, 4) != 0 || header.version != FONT_PARTITION_VERSION ||
+        header.image_size > part->size ||
+        sizeof(header) + (uint64_t)header.font_count * sizeof(font_partition_entry_t) > header.image_size) {
+        ESP_LOGW(TAG, "no valid font image");
+        return 0;
+    }
+    const void* mapped;
+    esp_err_t err = esp_partition_mmap(part, 0, header.image_size, ESP_PARTITION_MMAP_DATA, &mapped, &mmap_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mmap failed: %d", err);
+        return 0;
+    }
+    image = mapped;
+
+    const font_partition_entry_t* entries = (const font_partition_entry_t*)(image + sizeof(header));
+    for (int i = 0; i < header.font_count && font_count < FONT_PARTITION_FONTS; i++) {
+        const font_partition_entry_t* entry = &entries[i];
+        if (entry->offset % 4 != 0 || entry->offset > header.image_size ||
+            entry->size > header.image_size - entry->offset || !load_font(entry, &packs[font_count])) {
+            ESP_LOGW(TAG, "skipping invalid font %d", i);
+            continue;
+        }
+        memcpy(names[font_count], entry->name, FONT_PARTITION_NAME_MAX);
+        names[font_count][FONT_PARTITION_NAME_MAX - 1] = 0;
+        ESP_LOGI(TAG, "font %s: %" PRIu32 " glyphs", names[font_count], packs[font_count].glyph_count);
+        font_count++;
+    }
+    return font_count;
+}
+
+const EpdFont* font_partition_find(const char* name) {
+    for (int i = 0; i < font_count; i++) {
+        if (strncmp(names[i], name, FONT_PARTITION_NAME_MAX) == 0) {
+            return &packs[i].font;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 数据分区中的字体：镜像由 font_partition.py 从 TTF 生成，挂载时用 esp_partition_mmap 映射，
+// 位图和码点索引通过 flash 缓存直接读取，只有字形表转换后放在 PSRAM 中。
+// 每个字体都是字体包（见 font_pack.h），可以像编译进固件的 EpdFont 一样传给 text_draw_string
+#define FONT_PARTITION_LABEL    "fonts"
+#define FONT_PARTITION_SUBTYPE  0x40
+#define FONT_PARTITION_MAGIC    "EFPT"
+#define FONT_PARTITION_VERSION  1
+#define FONT_PARTITION_NAME_MAX 16
+#define FONT_PARTITION_FONTS    4 // 最多挂载的字体数
+
+// 以下是镜像中的格式，小端，各段按4字节对齐
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t font_count;
+    uint32_t image_size;
+} font_partition_header_t; // 之后是 font_count 个 font_partition_entry_t
+
+typedef struct {
+    char name[FONT_PARTITION_NAME_MAX];
+    uint32_t offset; // 字体记录相对镜像开头的偏移
+    uint32_t size;
+} font_partition_entry_t;
+
+typedef struct {
+    uint16_t advance_y;
+    uint8_t compressed;
+    uint8_t reserved;
+    int32_t ascender;
+    int32_t descender;
+    uint32_t glyph_count;
+    uint32_t interval_count;
+    uint32_t page_count;
+    uint16_t fallback;
+    uint16_t reserved2;
+    // 各段相对字体记录开头的偏移
+    uint32_t glyphs;    // font_partition_glyph_t[glyph_count]
+    uint32_t intervals; // EpdUnicodeInterval[interval_count]
+    uint32_t page_map;  // uint16_t[page_count]
+    uint32_t pages;     // uint16_t[256 * 页数]
+    uint32_t bitmap;    // 以 FONT_PACK_MAGIC 开头的位图数据
+    uint32_t bitmap_size;
+} font_partition_font_t;
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t advance_x;
+    int16_t left;
+    int16_t top;
+    uint16_t reserved;
+    uint32_t compressed_size;
+    uint32_t data_offset;
+} font_partition_glyph_t;
+
+// 查找并映射 fonts 分区，返回挂载的字体数；没有分区或镜像无效时返回0
+int font_partition_mount(void);
+
+// 按名称查找已挂载的字体，没有时返回 NULL
+const EpdFont* font_partition_find(const char* name);
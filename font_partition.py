@@ -0,0 +1,132 @@
+import argparse
+import struct
+import sys
+
+from PIL import ImageFont
+
+import font_pack
+
+# 字体分区镜像生成器：把 TTF 按字号渲染成4bpp字形，用 font_pack.py 相同的方式压缩并建立两级索引，
+# 输出可以写入 fonts 数据分区的镜像。设备端用 esp_partition_mmap 直接读取，见 font_partition.c。
+# 用法：python font_partition.py fonts.bin cjk:NotoSansSC-Regular.otf:16 --ranges 0x20-0x7E,0x4E00-0x9FFF
+#      parttool.py write_partition --partition-name fonts --input fonts.bin
+#      （需要 8MB flash 并用 sdkconfig.defaults.fonts 构建，见 README.md）
+
+# 与 font_partition.h 保持一致
+FONT_PARTITION_MAGIC = b'EFPT'
+FONT_PARTITION_VERSION = 1
+FONT_PARTITION_NAME_MAX = 16
+HEADER_FORMAT = '<4sHHI'             # 魔数、版本、字体数、镜像大小
+ENTRY_FORMAT = '<16sII'              # 名称、字体记录偏移、字体记录大小
+FONT_FORMAT = '<HBBiiIIIHH6I'        # 见 font_partition.h 中的 font_partition_font_t
+GLYPH_FORMAT = '<HHHhhHII'
+
+DEFAULT_RANGES = '0x20-0x7E,0x3000-0x303F,0x4E00-0x9FFF,0xFF00-0xFFEF'
+
+
+def align(data, n=4):
+    data.extend(b'\0' * (-len(data) % n))
+
+
+def render_font(path, size, codepoints):
+    """渲染字形，返回 (位图, 字形列表, 码点区间, (advance_y, ascender, descender))，字形格式与 parse_font 相同"""
+    font = ImageFont.truetype(path, size)
+    ascent, descent = font.getmetrics()
+    # PIL 不提供 cmap，字体中没有的字符会画成 .notdef 方框，与非字符 U+FFFF 的渲染结果相同
+    notdef = font.getmask2('\uFFFF', mode='L', anchor='ls')
+    notdef = (notdef[0].size, bytes(notdef[0]), notdef[1])
+    bitmaps, glyphs, kept = [], [], []
+    for cp in sorted(codepoints):
+        ch = chr(cp)
+        mask, (left, offset_y) = font.getmask2(ch, mode='L', anchor='ls')
+        if (mask.size, bytes(mask), (left, offset_y)) == notdef or (cp != 0x20 and not mask.getbbox()):
+            continue  # 字体中没有，或是空格以外的空白字符
+        width, height = mask.size
+        rows = bytearray()
+        for y in range(height):
+            row = [mask.getpixel((x, y)) >> 4 for x in range(width)] + [0]
+            rows.extend(row[x] | (row[x + 1] << 4) for x in range(0, width, 2))
+        bitmaps.append(bytes(rows))
+        glyphs.append((width, height, round(font.getlength(ch)), left, -offset_y, 0, 0))
+        kept.append(cp)
+    intervals = []
+    for i, cp in enumerate(kept):
+        if intervals and intervals[-1][1] == cp - 1:
+            intervals[-1][1] = cp
+        else:
+            intervals.append([cp, cp, i])
+    return bitmaps, glyphs, [tuple(iv) for iv in intervals], (ascent + descent, ascent, -descent)
+
+
+def font_record(bitmaps, glyphs, intervals, metrics, hot, fallback_spec):
+    data, packed_glyphs, _ = font_pack.build_pack(bitmaps, glyphs, intervals, font_pack.parse_ranges(hot))
+    page_map, pages = font_pack.build_index(len(glyphs), intervals)
+    fallback = font_pack.find_fallback(intervals, fallback_spec)
+
+    # 各段相对字体记录开头的偏移，都按4字节对齐，设备上可以直接当作数组使用
+    body = bytearray()
+    offsets = []
+    sections = [
+        b''.join(struct.pack(GLYPH_FORMAT, w, h, adv, left, top, 0, size, off)
+                 for w, h, adv, left, top, size, off in packed_glyphs),
+        b''.join(struct.pack('<III', *iv) for iv in intervals),
+        struct.pack(f'<{len(page_map)}H', *page_map),
+        struct.pack(f'<{len(pages)}H', *pages),
+        data,
+    ]
+    for section in sections:
+        offsets.append(struct.calcsize(FONT_FORMAT) + len(body))
+        body.extend(section)
+        align(body)
+    advance_y, ascender, descender = metrics
+    header = struct.pack(FONT_FORMAT, advance_y, 1, 0, ascender, descender, len(glyphs), len(intervals),
+                         len(page_map), fallback, 0, *offsets, len(data))
+    return header + bytes(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='从 TTF/OTF 生成 fonts 分区镜像')
+    parser.add_argument('output', help='输出的分区镜像')
+    parser.add_argument('fonts', nargs='+', metavar='NAME:PATH:SIZE', help='字体名称（设备上用它查找）、字体文件和字号')
+    parser.add_argument('--ranges', default=DEFAULT_RANGES, help='包含的码点范围')
+    parser.add_argument('--subset', nargs='+', metavar='SOURCE', help='只包含这些 C 源文件字符串中的字符和 --keep')
+    parser.add_argument('--keep', default=font_pack.DEFAULT_KEEP, help='子集中总是保留的码点范围')
+    parser.add_argument('--hot', default=font_pack.DEFAULT_HOT_RANGES, help='不压缩的码点范围')
+    parser.add_argument('--fallback', default=font_pack.DEFAULT_FALLBACK, help='缺字时代替的码点')
+    args = parser.parse_args()
+
+    codepoints = set()
+    if args.subset:
+        for first, last in font_pack.parse_ranges(args.keep):
+            codepoints.update(range(first, last + 1))
+        for path in args.subset:
+            codepoints.update(cp for cp in font_pack.source_codepoints(path) if cp >= 0x20)
+    else:
+        for first, last in font_pack.parse_ranges(args.ranges):
+            codepoints.update(range(first, last + 1))
+
+    records = []
+    for spec in args.fonts:
+        name, path, size = spec.rsplit(':', 2)
+        if len(name.encode()) >= FONT_PARTITION_NAME_MAX:
+            raise ValueError(f'字体名称 {name} 过长')
+        bitmaps, glyphs, intervals, metrics = render_font(path, int(size), codepoints)
+        records.append((name, font_record(bitmaps, glyphs, intervals, metrics, args.hot, args.fallback)))
+        print(f'{name}: {len(glyphs)} 个字形，{len(records[-1][1])} 字节', file=sys.stderr)
+
+    image = bytearray()
+    offset = struct.calcsize(HEADER_FORMAT) + struct.calcsize(ENTRY_FORMAT) * len(records)
+    for name, record in records:
+        image.extend(struct.pack(ENTRY_FORMAT, name.encode(), offset, len(record)))
+        offset += len(record)
+    for _, record in records:
+        image.extend(record)
+    header = struct.pack(HEADER_FORMAT, FONT_PARTITION_MAGIC, FONT_PARTITION_VERSION, len(records),
+                         struct.calcsize(HEADER_FORMAT) + len(image))
+    with open(args.output, 'wb') as f:
+        f.write(header + image)
+    print(f'{args.output}: {len(header) + len(image)} 字节', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,162 @@
+#include "font_sdf.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <math.h>
+#include <string.h>
+
+#include "font_pack.h"
+
+static const char* TAG = "font_sdf";
+
+typedef struct {
+    EpdFont font;  // 必须是第一个成员
+    const font_sdf_t* sdf;
+    int size;
+    float scale;   // 输出像素 / 资源像素
+} sdf_instance_t;
+
+static sdf_instance_t instances[FONT_SDF_INSTANCES];
+static int instance_count = 0;
+static uint8_t field[FONT_SDF_MAX_BITMAP]; // 解压后的距离场
+
+// 轮廓附近 (spread - 1) 个资源像素以外的距离场在任何字号下都是空白，不计入输出位图
+static int inset(const font_sdf_t* sdf) {
+    return sdf->spread > 1 ? sdf->spread - 1 : 0;
+}
+
+// 按实例的缩放计算字形位图的位置和尺寸，超出 EpdGlyph 字段范围时返回 false
+static bool scale_glyph(const sdf_instance_t* inst, uint32_t index, EpdGlyph* out) {
+    const font_sdf_glyph_t* g = &inst->sdf->glyphs[index];
+    float k = inst->scale;
+    int advance = lroundf(g->advance_x * k / FONT_SDF_FIXED);
+    memset(out, 0, sizeof(*out));
+    out->data_offset = index; // 距离场字形序号，由 font_sdf_render 使用
+    if (advance > UINT8_MAX) {
+        return false;
+    }
+    out->advance_x = advance;
+    if (g->width == 0 || g->height == 0) {
+        return true;
+    }
+
+    float left = (float)g->left / FONT_SDF_FIXED + inset(inst->sdf);
+    float top = (float)-g->top / FONT_SDF_FIXED + inset(inst->sdf); // y 向下
+    int x0 = floorf(left * k);
+    int y0 = floorf(top * k);
+    int x1 = ceilf((left + g->width - 2 * inset(inst->sdf)) * k);
+    int y1 = ceilf((top + g->height - 2 * inset(inst->sdf)) * k);
+    if (x1 - x0 > UINT8_MAX || y1 - y0 > UINT8_MAX) {
+        return false;
+    }
+    out->width = x1 > x0 ? x1 - x0 : 0;
+    out->height = y1 > y0 ? y1 - y0 : 0;
+    out->left = x0;
+    out->top = -y0;
+    out->compressed_size = (out->width + 1) / 2 * out->height; // 不为0，glyph_cache 才会调用 font_sdf_render
+    return true;
+}
+
+const EpdFont* font_sdf_get(const font_sdf_t* sdf, int size) {
+    for (int i = 0; i < instance_count; i++) {
+        if (instances[i].sdf == sdf && instances[i].size == size) {
+            return &instances[i].font;
+        }
+    }
+    if (instance_count >= FONT_SDF_INSTANCES || size <= 0 || sdf->advance_y == 0) {
+        ESP_LOGW(TAG, "cannot create size %d", size);
+        return NULL;
+    }
+
+    sdf_instance_t* inst = &instances[instance_count];
+    inst->sdf = sdf;
+    inst->size = size;
+    inst->scale = (float)size / sdf->advance_y;
+    EpdGlyph* glyphs = heap_caps_malloc(sdf->glyph_count * sizeof(EpdGlyph), MALLOC_CAP_SPIRAM);
+    if (glyphs == NULL) {
+        ESP_LOGW(TAG, "no memory for size %d", size);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < sdf->glyph_count; i++) {
+        if (!scale_glyph(inst, i, &glyphs[i])) {
+            ESP_LOGW(TAG, "size %d too large", size);
+            heap_caps_free(glyphs);
+            return NULL;
+        }
+    }
+
+    inst->font = (EpdFont){
+        .bitmap = sdf->data,
+        .glyph = glyphs,
+        .intervals = sdf->intervals,
+        .interval_count = sdf->interval_count,
+        .compressed = true,
+        .advance_y = size,
+        .ascender = lroundf(sdf->ascender * inst->scale),
+        .descender = lroundf(sdf->descender * inst->scale),
+    };
+    instance_count++;
+    return &inst->font;
+}
+
+// 距离场以外当作完全在轮廓外
+static float field_at(const uint8_t* src, int w, int h, int x, int y) {
+    return (x >= 0 && x < w && y >= 0 && y < h) ? src[y * w + x] : 0;
+}
+
+bool font_sdf_is_sdf(const EpdFont* font) {
+    return font->compressed && memcmp(font->bitmap, FONT_SDF_MAGIC, 4) == 0;
+}
+
+bool font_sdf_render(const EpdFont* font, const EpdGlyph* glyph, uint8_t* out) {
+    const sdf_instance_t* inst = (const sdf_instance_t*)font;
+    const font_sdf_t* sdf = inst->sdf;
+    if (glyph->data_offset >= sdf->glyph_count) {
+        return false;
+    }
+    const font_sdf_glyph_t* g = &sdf->glyphs[glyph->data_offset];
+    int w = g->width;
+    int h = g->height;
+    uint32_t size = w * h;
+    if (size > sizeof(field)) {
+        return false;
+    }
+    const uint8_t* src = sdf->data + g->data_offset;
+    if (g->compressed_size != 0) {
+        if (!font_pack_decode(src, g->compressed_size, field, size)) {
+            return false;
+        }
+        src = field;
+    }
+
+    // 输出像素中心换算到距离场坐标后双线性插值；距离换算成输出像素，轮廓处覆盖一半
+    float inv_k = 1.0f / inst->scale;
+    float origin_x = (float)g->left / FONT_SDF_FIXED + 0.5f;
+    float origin_y = (float)-g->top / FONT_SDF_FIXED + 0.5f;
+    float gain = (float)sdf->spread * inst->scale * 15.0f / 127.0f;
+    int row_bytes = (glyph->width + 1) / 2;
+    memset(out, 0, row_bytes * glyph->height);
+    for (int oy = 0; oy < glyph->height; oy++) {
+        float fy = (-glyph->top + oy + 0.5f) * inv_k - origin_y;
+        int y = floorf(fy);
+        float ty = fy - y;
+        for (int ox = 0; ox < glyph->width; ox++) {
+            float fx = (glyph->left + ox + 0.5f) * inv_k - origin_x;
+            int x = floorf(fx);
+            float tx = fx - x;
+            float top = field_at(src, w, h, x, y) + (field_at(src, w, h, x + 1, y) - field_at(src, w, h, x, y)) * tx;
+            float bottom =
+                field_at(src, w, h, x, y + 1) + (field_at(src, w, h, x + 1, y + 1) - field_at(src, w, h, x, y + 1)) * tx;
+            float v = top + (bottom - top) * ty;
+            int level = lroundf((v - 128.0f) * gain + 7.5f);
+            if (level <= 0) {
+                continue;
+            }
+            if (level > 15) {
+                level = 15;
+            }
+            out[oy * row_bytes + ox / 2] |= (ox & 1) ? level << 4 : level;
+        }
+    }
+    return true;
+}
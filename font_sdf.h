@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 距离场（SDF）字体：font_sdf.py 生成的一份资源可以按任意行高创建字体实例。每个字形保存一个8位有符号距离场
+// （128 为轮廓，内部更大，±spread 个资源像素饱和），用到时由 glyph_cache 调用 font_sdf_render 双线性插值
+// 栅格化成4bpp位图并缓存。数据以 FONT_SDF_MAGIC 开头，compressed_size 不为0的字形是 font_pack 格式的 LZSS 数据
+#define FONT_SDF_MAGIC      "ESD1"
+#define FONT_SDF_FIXED      16   // 字形位置和 advance_x 的定点小数倍数
+#define FONT_SDF_MAX_BITMAP 4096 // 单个字形距离场的最大字节数
+#define FONT_SDF_INSTANCES  4
+
+typedef struct {
+    uint8_t width;           // 距离场尺寸（资源像素），含 spread 边
+    uint8_t height;
+    int16_t left;            // 距离场左上角相对笔位置和基线，FONT_SDF_FIXED 定点数
+    int16_t top;
+    uint16_t advance_x;      // FONT_SDF_FIXED 定点数
+    uint32_t compressed_size; // 0 表示原样存放
+    uint32_t data_offset;
+} font_sdf_glyph_t;
+
+typedef struct {
+    const uint8_t* data;
+    const font_sdf_glyph_t* glyphs;
+    const EpdUnicodeInterval* intervals;
+    uint32_t interval_count;
+    uint32_t glyph_count;
+    uint16_t advance_y;      // 资源本身的行高，实例按 行高 / advance_y 缩放
+    int16_t ascender;
+    int16_t descender;
+    uint8_t spread;
+} font_sdf_t;
+
+// 行高为 size 像素的字体实例，可以当作普通 EpdFont 传给 text_render 和 text_layout。同一资源和行高返回同一实例；
+// 实例已满、内存不足或字形超出 EpdGlyph 的尺寸时返回 NULL
+const EpdFont* font_sdf_get(const font_sdf_t* sdf, int size);
+
+// font 是否是距离场字体实例
+bool font_sdf_is_sdf(const EpdFont* font);
+
+// 把实例的一个字形栅格化到 out（(width + 1) / 2 * height 字节），数据损坏时返回 false
+bool font_sdf_render(const EpdFont* font, const EpdGlyph* glyph, uint8_t* out);
@@ -0,0 +1,193 @@
+import argparse
+import math
+import os
+import sys
+
+import font_pack
+
+# SDF 字体生成器：把字体的字形转换成有符号距离场，一份资源可以在设备上渲染成任意字号（见 font_sdf.c）。
+# 输入是 epdiy 字体头文件（用其中的抗锯齿位图）或 TTF/OTF（用 Pillow 渲染，需要 --size）。
+# 距离场按 --scale 缩小后保存，每像素8位，用 font_pack 的 LZSS 压缩。从字体头文件生成的资源放大到源字号的
+# 4倍以上时轮廓会变得不平滑，需要很大的字号时用 TTF 以较大的 --size 生成
+# 用法：python font_sdf.py firasans_20.h firasans_20_sdf.h（构建时由 font_pack.cmake 的 font_sdf_add 调用）
+#      python font_sdf.py FiraSans-Regular.ttf firasans_sdf.h --size 64 --name FiraSansSdf
+
+# 与 font_sdf.h 保持一致
+FONT_SDF_MAGIC = b'ESD1'
+FONT_SDF_FIXED = 16  # 位置和宽度的定点小数倍数
+FONT_SDF_MAX_BITMAP = 4096
+
+INF = 1e20
+
+
+def edt_1d(f):
+    """一维平方距离变换（Felzenszwalb & Huttenlocher）"""
+    n = len(f)
+    d = [0.0] * n
+    v = [0] * n
+    z = [0.0] * (n + 1)
+    k = 0
+    z[0], z[1] = -INF, INF
+    for q in range(1, n):
+        s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k])
+        while s <= z[k]:
+            k -= 1
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k])
+        k += 1
+        v[k] = q
+        z[k] = s
+        z[k + 1] = INF
+    k = 0
+    for q in range(n):
+        while z[k + 1] < q:
+            k += 1
+        d[q] = (q - v[k]) ** 2 + f[v[k]]
+    return d
+
+
+def edt(targets, width, height):
+    """每个像素到最近的目标像素中心的距离"""
+    grid = [[0.0 if targets[y][x] else INF for x in range(width)] for y in range(height)]
+    for x in range(width):
+        column = edt_1d([grid[y][x] for y in range(height)])
+        for y in range(height):
+            grid[y][x] = column[y]
+    return [[math.sqrt(v) for v in edt_1d(row)] for row in grid]
+
+
+def signed_distance(coverage, width, height):
+    """coverage 为 0..15 的覆盖率，返回像素中心到轮廓的有符号距离（内部为正，单位为源像素）。
+    边缘的抗锯齿像素直接用覆盖率估计亚像素距离"""
+    inside = [[coverage[y][x] >= 8 for x in range(width)] for y in range(height)]
+    outside = [[not v for v in row] for row in inside]
+    to_outside = edt(outside, width, height)
+    to_inside = edt(inside, width, height)
+    result = []
+    for y in range(height):
+        row = []
+        for x in range(width):
+            c = coverage[y][x]
+            if 0 < c < 15:
+                row.append(c / 15 - 0.5)
+            elif inside[y][x]:
+                row.append(to_outside[y][x] - 0.5)
+            else:
+                row.append(0.5 - to_inside[y][x])
+        result.append(row)
+    return result
+
+
+def glyph_sdf(bitmap, width, height, pad, scale, spread):
+    """源位图四周留出 pad 个源像素后计算距离场，缩小到资源分辨率，返回 (字节, 宽, 高)"""
+    pw, ph = width + 2 * pad, height + 2 * pad
+    coverage = [[0] * pw for _ in range(ph)]
+    byte_width = (width + 1) // 2
+    for y in range(height):
+        for x in range(width):
+            b = bitmap[y * byte_width + x // 2]
+            coverage[y + pad][x + pad] = (b >> 4) if x & 1 else (b & 0x0F)
+    sd = signed_distance(coverage, pw, ph)
+
+    # 每个资源像素取它覆盖的源像素的平均距离
+    out_w, out_h = max(1, round(pw * scale)), max(1, round(ph * scale))
+    data = bytearray()
+    for oy in range(out_h):
+        y0 = min(int(oy / scale), ph - 1)
+        y1 = max(y0 + 1, min(int((oy + 1) / scale), ph))
+        for ox in range(out_w):
+            x0 = min(int(ox / scale), pw - 1)
+            x1 = max(x0 + 1, min(int((ox + 1) / scale), pw))
+            d = sum(sd[y][x] for y in range(y0, y1) for x in range(x0, x1)) / ((y1 - y0) * (x1 - x0))
+            data.append(max(0, min(255, round(128 + d * scale * 127 / spread))))
+    return bytes(data), out_w, out_h
+
+
+def build_sdf(bitmaps, glyphs, scale, spread):
+    """spread 为资源像素；返回 (数据, 字形表)"""
+    pad = math.ceil(spread / scale)
+    data = bytearray(FONT_SDF_MAGIC)
+    out = []
+    for bitmap, (width, height, advance_x, left, top, _, _) in zip(bitmaps, glyphs):
+        advance = round(advance_x * scale * FONT_SDF_FIXED)
+        if width == 0 or height == 0:
+            out.append((0, 0, 0, 0, advance, 0, len(data)))
+            continue
+        raw, out_w, out_h = glyph_sdf(bitmap, width, height, pad, scale, spread)
+        if len(raw) > FONT_SDF_MAX_BITMAP or out_w > 255 or out_h > 255:
+            raise ValueError(f'字形距离场 {out_w}x{out_h} 过大，减小 --scale')
+        packed = font_pack.lzss_compress(raw)
+        stored, size = (packed, len(packed)) if len(packed) < len(raw) else (raw, 0)
+        # 距离场左上角相对笔位置和基线，资源像素的定点数
+        out.append((out_w, out_h, round((left - pad) * scale * FONT_SDF_FIXED),
+                    round((top + pad) * scale * FONT_SDF_FIXED), advance, size, len(data)))
+        data.extend(stored)
+    return bytes(data), out
+
+
+def write_header(path, source, name, data, glyphs, intervals, metrics, spread):
+    advance_y, ascender, descender = metrics
+    lines = [
+        '#pragma once',
+        f'// 由 font_sdf.py 从 {os.path.basename(source)} 生成，不要手动修改',
+        '#include "font_sdf.h"',
+    ]
+    font_pack.append_array(lines, f'const uint8_t {name}Data[{len(data)}]', data, '0x{:02X}')
+    lines.append(f'const font_sdf_glyph_t {name}Glyphs[] = {{')
+    for g in glyphs:
+        lines.append('    {' + ', '.join(str(v) for v in g) + '},')
+    lines.append('};')
+    lines.append(f'const EpdUnicodeInterval {name}Intervals[] = {{')
+    for first, last, offset in intervals:
+        lines.append(f'    {{0x{first:X}, 0x{last:X}, 0x{offset:X}}},')
+    lines.append('};')
+    lines.append(f'const font_sdf_t {name} = {{')
+    lines.append(f'    {name}Data, {name}Glyphs, {name}Intervals, {len(intervals)}, {len(glyphs)},')
+    lines.append(f'    {advance_y}, {ascender}, {descender}, {spread},')
+    lines.append('};')
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='把字体转换成有符号距离场（SDF）字体资源')
+    parser.add_argument('input', help='epdiy 字体头文件，或 TTF/OTF（需要 --size）')
+    parser.add_argument('output', help='输出的头文件')
+    parser.add_argument('--name', help='资源名称，默认为 <字体名>Sdf')
+    parser.add_argument('--size', type=int, help='TTF/OTF 的渲染字号（像素）')
+    parser.add_argument('--ranges', default='0x20-0x7E', help='TTF/OTF 包含的码点范围')
+    parser.add_argument('--scale', type=float, default=0.5, help='距离场相对源位图的缩放')
+    parser.add_argument('--spread', type=int, default=2, help='距离场覆盖的范围（资源像素）')
+    parser.add_argument('--subset', nargs='+', metavar='SOURCE', help='只保留这些 C 源文件字符串中的字符和 --keep')
+    parser.add_argument('--keep', default=font_pack.DEFAULT_KEEP, help='子集中总是保留的码点范围')
+    args = parser.parse_args()
+
+    if args.input.endswith('.h'):
+        name, bitmaps, glyphs, intervals, metrics = font_pack.parse_font(args.input)
+        metrics = [int(v) for v in metrics]
+    else:
+        import font_partition
+        if args.size is None:
+            parser.error('TTF/OTF 需要 --size')
+        codepoints = set()
+        for first, last in font_pack.parse_ranges(args.ranges):
+            codepoints.update(range(first, last + 1))
+        bitmaps, glyphs, intervals, metrics = font_partition.render_font(args.input, args.size, codepoints)
+        name = os.path.splitext(os.path.basename(args.input))[0].replace('-', '_')
+    if args.subset:
+        keep = set()
+        for first, last in font_pack.parse_ranges(args.keep):
+            keep.update(range(first, last + 1))
+        for path in args.subset:
+            keep.update(font_pack.source_codepoints(path))
+        bitmaps, glyphs, intervals = font_pack.subset_font(bitmaps, glyphs, intervals, keep)
+
+    data, sdf_glyphs = build_sdf(bitmaps, glyphs, args.scale, args.spread)
+    advance_y, ascender, descender = metrics
+    scaled = [round(advance_y * args.scale), round(ascender * args.scale), round(descender * args.scale)]
+    name = args.name or name + 'Sdf'
+    write_header(args.output, args.input, name, data, sdf_glyphs, intervals, scaled, args.spread)
+    print(f'{name}: {len(glyphs)} 个字形，距离场 {len(data)} 字节，基准行高 {scaled[0]} 像素', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,124 @@
+#include "ghost_budget.h"
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <inttypes.h>
+#include <string.h>
+
+static const char* TAG = "ghost_budget";
+
+#define GHOST_MAGIC 0x47485354u
+
+// 深度睡眠期间保留；冷启动后内容不确定，用 magic 区分
+typedef struct {
+    uint32_t magic;
+    uint16_t cost[GHOST_ROWS][GHOST_COLS];
+    ghost_budget_stats_t stats;
+} ghost_state_t;
+
+RTC_DATA_ATTR static ghost_state_t ghost;
+static int screen_width = 0;
+static int screen_height = 0;
+
+static int cell_x(int col) {
+    return col * screen_width / GHOST_COLS;
+}
+
+static int cell_y(int row) {
+    return row * screen_height / GHOST_ROWS;
+}
+
+void ghost_budget_init(int width, int height) {
+    screen_width = width;
+    screen_height = height;
+    if (ghost.magic != GHOST_MAGIC) {
+        memset(&ghost, 0, sizeof(ghost));
+        ghost.magic = GHOST_MAGIC;
+    } else {
+        ESP_LOGI(TAG, "restored, %" PRIu32 " cleans so far", ghost.stats.cleans);
+    }
+}
+
+uint16_t ghost_budget_cost(enum EpdDrawMode mode, bool mono) {
+    switch (mode & 0x0F) {
+    case MODE_GC16:
+        return 0;
+    case MODE_GL16:
+    case MODE_GC16_FAST:
+        return 1;
+    case MODE_DU:
+        return mono ? 2 : 4;
+    case MODE_A2:
+        return mono ? 2 : 6;
+    default:
+        return 1;
+    }
+}
+
+void ghost_budget_charge(EpdRect area, enum EpdDrawMode mode, bool mono) {
+    uint16_t cost = ghost_budget_cost(mode, mono);
+    if (cost == 0 || area.width <= 0 || area.height <= 0) {
+        return;
+    }
+    ghost.stats.charges++;
+    for (int row = 0; row < GHOST_ROWS; row++) {
+        if (area.y >= cell_y(row + 1) || area.y + area.height <= cell_y(row)) {
+            continue;
+        }
+        for (int col = 0; col < GHOST_COLS; col++) {
+            if (area.x >= cell_x(col + 1) || area.x + area.width <= cell_x(col)) {
+                continue;
+            }
+            uint32_t total = ghost.cost[row][col] + cost;
+            ghost.cost[row][col] = total > UINT16_MAX ? UINT16_MAX : total;
+        }
+    }
+}
+
+void ghost_budget_reset(EpdRect area) {
+    int cleaned = 0;
+    for (int row = 0; row < GHOST_ROWS; row++) {
+        if (area.y > cell_y(row) || area.y + area.height < cell_y(row + 1)) {
+            continue;
+        }
+        for (int col = 0; col < GHOST_COLS; col++) {
+            if (area.x > cell_x(col) || area.x + area.width < cell_x(col + 1)) {
+                continue;
+            }
+            ghost.cost[row][col] = 0;
+            cleaned++;
+        }
+    }
+    if (cleaned > 0) {
+        ghost.stats.cleans++;
+        ghost.stats.cleaned_area += cleaned;
+    }
+}
+
+bool ghost_budget_pending(bool hard, EpdRect* area) {
+    uint16_t limit = hard ? GHOST_BUDGET_HARD : GHOST_BUDGET;
+    int x0 = screen_width, y0 = screen_height, x1 = 0, y1 = 0;
+    for (int row = 0; row < GHOST_ROWS; row++) {
+        for (int col = 0; col < GHOST_COLS; col++) {
+            if (ghost.cost[row][col] < limit) {
+                continue;
+            }
+            x0 = cell_x(col) < x0 ? cell_x(col) : x0;
+            y0 = cell_y(row) < y0 ? cell_y(row) : y0;
+            x1 = cell_x(col + 1) > x1 ? cell_x(col + 1) : x1;
+            y1 = cell_y(row + 1) > y1 ? cell_y(row + 1) : y1;
+        }
+    }
+    if (x1 <= x0 || y1 <= y0) {
+        return false;
+    }
+    area->x = x0;
+    area->y = y0;
+    area->width = x1 - x0;
+    area->height = y1 - y0;
+    return true;
+}
+
+void ghost_budget_get_stats(ghost_budget_stats_t* stats) {
+    *stats = ghost.stats;
+}
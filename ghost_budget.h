@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 残影预算：屏幕划分为 GHOST_COLS x GHOST_ROWS 个区域，每次非清洁刷新按模式给覆盖的区域记账，
+// 超出预算的区域需要一次清洁刷新（先闪白再重画）。计数放在RTC内存中，深度睡眠后保留。
+// 只在显示任务中调用，不加锁
+#define GHOST_COLS        4
+#define GHOST_ROWS        4
+#define GHOST_BUDGET      24 // 超出后在空闲时清洁
+#define GHOST_BUDGET_HARD 48 // 超出后不再等待空闲，刷新结束后立即清洁
+
+typedef struct {
+    uint32_t charges;      // 记账的刷新次数
+    uint32_t cleans;       // 清洁刷新次数
+    uint32_t cleaned_area; // 清洁刷新的区域数合计
+} ghost_budget_stats_t;
+
+// 屏幕尺寸（旋转后的坐标）。深度睡眠唤醒时沿用RTC内存中的计数，冷启动时清零
+void ghost_budget_init(int width, int height);
+
+// 一次刷新的残影代价，以一次 GL16 为1：GC16 清洁刷新为0；DU/A2 波形短，灰度像素会停在中间值，
+// 有灰度内容时分别为4和6，即预算内约6次 DU 或4次 A2。mono 表示区域内只有黑白两色（如 TEXT_DRAW_MONO 的文字），
+// 这时快速模式只是在黑白之间切换，残影主要是电荷累积，代价为2，约12批控制台消息后空闲时清洁一次
+uint16_t ghost_budget_cost(enum EpdDrawMode mode, bool mono);
+
+// 给与 area 相交的区域记账
+void ghost_budget_charge(EpdRect area, enum EpdDrawMode mode, bool mono);
+
+// 完全包含在 area 中的区域已清洁，计数清零
+void ghost_budget_reset(EpdRect area);
+
+// 超出预算（hard 为 true 时只看硬上限）的区域的外接矩形，没有时返回 false
+bool ghost_budget_pending(bool hard, EpdRect* area);
+
+void ghost_budget_get_stats(ghost_budget_stats_t* stats);
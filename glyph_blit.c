@@ -0,0 +1,145 @@
+#include "glyph_blit.h"
+
+void glyph_blit_colors(glyph_blit_colors_t* colors, uint8_t fg_color, uint8_t bg_color, bool background, bool mono) {
+    int color_difference = (int)fg_color - (int)bg_color;
+    for (int c = 0; c < 16; c++) {
+        int color;
+        if (mono) {
+            color = c >= GLYPH_BLIT_MONO_THRESHOLD ? fg_color : bg_color;
+        } else {
+            color = bg_color + c * color_difference / 15;
+        }
+        colors->nibble[c] = color < 0 ? 0 : (color > 15 ? 15 : color);
+    }
+    for (int b = 0; b < 256; b++) {
+        int lo = b & 0x0F;
+        int hi = b >> 4;
+        bool lo_ink = mono ? lo >= GLYPH_BLIT_MONO_THRESHOLD : lo != 0;
+        bool hi_ink = mono ? hi >= GLYPH_BLIT_MONO_THRESHOLD : hi != 0;
+        colors->pair[b] = colors->nibble[lo] | (colors->nibble[hi] << 4);
+        colors->mask[b] = background ? 0xFF : (lo_ink ? 0x0F : 0) | (hi_ink ? 0xF0 : 0);
+    }
+    colors->background = background;
+}
+
+const glyph_blit_colors_t* glyph_blit_colors_for(const EpdFontProperties* props, bool mono) {
+    static glyph_blit_colors_t colors;
+    static int key = -1;
+    bool background = props->flags & EPD_DRAW_BACKGROUND;
+    int k = props->fg_color | (props->bg_color << 4) | (background << 8) | (mono << 9);
+    if (k != key) {
+        glyph_blit_colors(&colors, props->fg_color, props->bg_color, background, mono);
+        key = k;
+    }
+    return &colors;
+}
+
+// 位图值是否需要写入（背景像素在不画背景时不写）
+static bool is_drawn(uint8_t value, const glyph_blit_colors_t* colors) {
+    return colors->mask[value] & 0x0F;
+}
+
+static void put_pixel(uint8_t* row, int x, uint8_t value, const glyph_blit_colors_t* colors) {
+    if (!is_drawn(value, colors)) {
+        return;
+    }
+    uint8_t* p = &row[x / 2];
+    if (x & 1) {
+        *p = (*p & 0x0F) | (colors->nibble[value] << 4);
+    } else {
+        *p = (*p & 0xF0) | colors->nibble[value];
+    }
+}
+
+static uint8_t pixel_at(const uint8_t* src, int x) {
+    return (x & 1) ? src[x / 2] >> 4 : src[x / 2] & 0x0F;
+}
+
+// 位图一行中 [sx, sx + count) 的像素写到帧缓冲区这一行的 dx 处
+static void blit_row(uint8_t* row, int dx, const uint8_t* src, int sx, int count, const glyph_blit_colors_t* colors) {
+    if (dx & 1) {
+        put_pixel(row, dx++, pixel_at(src, sx++), colors);
+        count--;
+    }
+    uint8_t* out = &row[dx / 2];
+    const uint8_t* in = &src[sx / 2];
+    int pairs = count / 2;
+    if (!(sx & 1)) {
+        // 位图与帧缓冲区按字节对齐
+        if (colors->background) {
+            for (int i = 0; i < pairs; i++) {
+                out[i] = colors->pair[in[i]];
+            }
+        } else {
+            for (int i = 0; i < pairs; i++) {
+                uint8_t b = in[i];
+                uint8_t mask = colors->mask[b];
+                if (mask == 0xFF) {
+                    out[i] = colors->pair[b];
+                } else if (mask) {
+                    out[i] = (out[i] & ~mask) | (colors->pair[b] & mask);
+                }
+            }
+        }
+    } else {
+        // 错开半个字节：每个输出字节由相邻两个位图字节拼成
+        for (int i = 0; i < pairs; i++) {
+            uint8_t b = (in[i] >> 4) | (in[i + 1] << 4);
+            uint8_t mask = colors->mask[b];
+            if (mask == 0xFF) {
+                out[i] = colors->pair[b];
+            } else if (mask) {
+                out[i] = (out[i] & ~mask) | (colors->pair[b] & mask);
+            }
+        }
+    }
+    if (count & 1) {
+        put_pixel(row, dx + count - 1, pixel_at(src, sx + count - 1), colors);
+    }
+}
+
+void glyph_blit(const uint8_t* bitmap, int width, int height, int x, int y, const glyph_blit_colors_t* colors,
+                uint8_t* framebuffer) {
+    int byte_width = (width + 1) / 2;
+    if (epd_get_rotation() != EPD_ROT_LANDSCAPE) {
+        for (int gy = 0; gy < height; gy++) {
+            const uint8_t* src = bitmap + gy * byte_width;
+            for (int gx = 0; gx < width; gx++) {
+                uint8_t value = pixel_at(src, gx);
+                if (is_drawn(value, colors)) {
+                    epd_draw_pixel(x + gx, y + gy, colors->nibble[value] << 4, framebuffer);
+                }
+            }
+        }
+        return;
+    }
+
+    int fb_width = epd_width();
+    int fb_height = epd_height();
+    int sx = x < 0 ? -x : 0;
+    int count = (x + width > fb_width ? fb_width - x : width) - sx;
+    if (count <= 0) {
+        return;
+    }
+    for (int gy = y < 0 ? -y : 0; gy < height && y + gy < fb_height; gy++) {
+        blit_row(framebuffer + (y + gy) * fb_width / 2, x + sx, bitmap + gy * byte_width, sx, count, colors);
+    }
+}
+
+void glyph_blit_mono(const uint8_t* bits, int width, int height, int x, int y, const glyph_blit_colors_t* colors,
+                     uint8_t* framebuffer) {
+    // 逐行展开成位图值 0/15 的4bpp行，再走与4bpp位图相同的合成路径
+    static const uint8_t expand[4] = {0x00, 0x0F, 0xF0, 0xFF};
+    uint8_t row[(UINT8_MAX + 1) / 2];
+    int byte_width = (width + 7) / 8;
+    if (width > UINT8_MAX) {
+        return;
+    }
+    for (int gy = 0; gy < height; gy++) {
+        const uint8_t* src = bits + gy * byte_width;
+        for (int i = 0; i < (width + 1) / 2; i++) {
+            row[i] = expand[(src[i / 4] >> (2 * (i % 4))) & 3];
+        }
+        glyph_blit(row, width, 1, x, y + gy, colors, framebuffer);
+    }
+}
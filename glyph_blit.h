@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 字形合成：把4bpp字形位图按行写入帧缓冲区。横屏（与面板原生方向相同）时一次处理一个字节（两个像素），
+// 不经过 epd_draw_pixel 的旋转和边界检查；其它方向逐像素绘制。
+// 黑白模式（mono）只写前景色和背景色两种灰度，供 MODE_DU 快速刷新：4bpp 位图按阈值二值化，
+// 也可以直接合成字体包生成的1bpp变体
+#define GLYPH_BLIT_MONO_THRESHOLD 8 // 与 font_pack.py 的 MONO_THRESHOLD 相同
+
+// 位图值到帧缓冲区的映射，同一组颜色可以在多个字形间复用
+typedef struct {
+    uint8_t nibble[16]; // 位图值 -> 灰度
+    uint8_t pair[256];  // 位图字节（两个像素）-> 帧缓冲区字节
+    uint8_t mask[256];  // 位图字节中需要写入的半字节；不画背景时背景像素不写
+    bool background;
+} glyph_blit_colors_t;
+
+// 与 epdiy 相同：位图值 0 为背景色，15 为前景色。mono 为 true 时不低于 GLYPH_BLIT_MONO_THRESHOLD 的值为前景色，
+// 其余为背景色
+void glyph_blit_colors(glyph_blit_colors_t* colors, uint8_t fg_color, uint8_t bg_color, bool background, bool mono);
+
+// 按 props 的颜色、EPD_DRAW_BACKGROUND 和 mono 取映射表，与上一次相同时不重新计算。只在显示任务中调用
+const glyph_blit_colors_t* glyph_blit_colors_for(const EpdFontProperties* props, bool mono);
+
+// (x, y) 是位图左上角在旋转后坐标系中的位置，超出屏幕的部分被裁掉
+void glyph_blit(const uint8_t* bitmap, int width, int height, int x, int y, const glyph_blit_colors_t* colors,
+                uint8_t* framebuffer);
+
+// 合成1bpp位图（每行 (width + 7) / 8 字节，低位是左边的像素），1 为前景色
+void glyph_blit_mono(const uint8_t* bits, int width, int height, int x, int y, const glyph_blit_colors_t* colors,
+                     uint8_t* framebuffer);
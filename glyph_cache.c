@@ -0,0 +1,235 @@
+#include "glyph_cache.h"
+
+#include "font_pack.h"
+#include "font_sdf.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <rom/miniz.h>
+#include <string.h>
+
+static const char* TAG = "glyph_cache";
+
+#define BLOCK_COUNT (GLYPH_CACHE_BYTES / GLYPH_CACHE_BLOCK)
+#define NONE        0xFFFF
+
+typedef struct {
+    const EpdFont* font;
+    const EpdGlyph* glyph;
+    uint16_t block;     // 位图在缓存区域中的起始块
+    uint16_t blocks;
+    uint16_t hash_next; // 同一个桶中的下一项
+    uint16_t lru_prev;  // 越靠前越久未使用
+    uint16_t lru_next;
+} glyph_entry_t;
+
+static uint8_t* arena = NULL;
+static uint8_t block_used[(BLOCK_COUNT + 7) / 8];
+static glyph_entry_t entries[GLYPH_CACHE_ENTRIES];
+static uint16_t buckets[GLYPH_CACHE_BUCKETS];
+static uint16_t free_head = NONE;
+static uint16_t lru_head = NONE; // 最久未使用
+static uint16_t lru_tail = NONE; // 最近使用
+static glyph_cache_stats_t stats;
+static uint8_t scratch[64 * 64 / 2]; // 缓存不可用或位图过大时临时解压到这里
+
+// 字形指针在字体内唯一对应一个码点，(字体, 字形) 即 (字体, 码点)
+static uint32_t bucket_of(const EpdFont* font, const EpdGlyph* glyph) {
+    uint32_t key = ((uint32_t)(uintptr_t)font ^ (uint32_t)(uintptr_t)glyph) * 2654435761u;
+    return (key >> 16) % GLYPH_CACHE_BUCKETS;
+}
+
+static uint32_t bitmap_size(const EpdGlyph* glyph) {
+    return (glyph->width + 1) / 2 * glyph->height;
+}
+
+static bool block_is_used(int block) {
+    return block_used[block / 8] & (1 << (block % 8));
+}
+
+static void mark_blocks(int start, int count, bool used) {
+    for (int i = start; i < start + count; i++) {
+        if (used) {
+            block_used[i / 8] |= 1 << (i % 8);
+        } else {
+            block_used[i / 8] &= ~(1 << (i % 8));
+        }
+    }
+}
+
+// 首次适配，找不到连续的空闲块时返回 -1
+static int find_blocks(int count) {
+    int run = 0;
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        run = block_is_used(i) ? 0 : run + 1;
+        if (run == count) {
+            return i - count + 1;
+        }
+    }
+    return -1;
+}
+
+static void lru_unlink(uint16_t index) {
+    glyph_entry_t* e = &entries[index];
+    if (e->lru_prev != NONE) {
+        entries[e->lru_prev].lru_next = e->lru_next;
+    } else {
+        lru_head = e->lru_next;
+    }
+    if (e->lru_next != NONE) {
+        entries[e->lru_next].lru_prev = e->lru_prev;
+    } else {
+        lru_tail = e->lru_prev;
+    }
+}
+
+static void lru_append(uint16_t index) {
+    glyph_entry_t* e = &entries[index];
+    e->lru_prev = lru_tail;
+    e->lru_next = NONE;
+    if (lru_tail != NONE) {
+        entries[lru_tail].lru_next = index;
+    } else {
+        lru_head = index;
+    }
+    lru_tail = index;
+}
+
+// 淘汰最久未使用的一项，没有可淘汰的项时返回 false
+static bool evict_one(void) {
+    uint16_t index = lru_head;
+    if (index == NONE) {
+        return false;
+    }
+    glyph_entry_t* e = &entries[index];
+    lru_unlink(index);
+
+    uint16_t* link = &buckets[bucket_of(e->font, e->glyph)];
+    while (*link != index) {
+        link = &entries[*link].hash_next;
+    }
+    *link = e->hash_next;
+
+    mark_blocks(e->block, e->blocks, false);
+    stats.bytes_used -= e->blocks * GLYPH_CACHE_BLOCK;
+    stats.evictions++;
+    e->hash_next = free_head;
+    free_head = index;
+    return true;
+}
+
+// 解压字形位图，距离场字体在这里栅格化
+static bool inflate_glyph(const EpdFont* font, const EpdGlyph* glyph, uint8_t* out) {
+    uint32_t size = bitmap_size(glyph);
+    if (font_sdf_is_sdf(font)) {
+        return font_sdf_render(font, glyph, out);
+    }
+    if (font_pack_is_packed(font)) {
+        return font_pack_decode(font->bitmap + glyph->data_offset, glyph->compressed_size, out, size);
+    }
+    size_t len = tinfl_decompress_mem_to_mem(out, size, font->bitmap + glyph->data_offset, glyph->compressed_size,
+                                             TINFL_FLAG_PARSE_ZLIB_HEADER);
+    return len == size;
+}
+
+bool glyph_cache_init(void) {
+    arena = heap_caps_malloc(GLYPH_CACHE_BYTES, MALLOC_CAP_SPIRAM);
+    glyph_cache_clear();
+    if (arena == NULL) {
+        ESP_LOGW(TAG, "no memory for %d byte cache", GLYPH_CACHE_BYTES);
+    }
+    return arena != NULL;
+}
+
+void glyph_cache_clear(void) {
+    memset(block_used, 0, sizeof(block_used));
+    memset(buckets, 0xFF, sizeof(buckets));
+    for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        entries[i].hash_next = i + 1 < GLYPH_CACHE_ENTRIES ? i + 1 : NONE;
+    }
+    free_head = 0;
+    lru_head = lru_tail = NONE;
+    stats.bytes_used = 0;
+}
+
+const EpdGlyph* glyph_lookup(const EpdFont* font, uint32_t codepoint) {
+    if (font_pack_is_packed(font)) {
+        return font_pack_lookup((const font_pack_t*)font, codepoint);
+    }
+    // 普通 epdiy 字体：二分查找码点区间
+    int lo = 0;
+    int hi = (int)font->interval_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const EpdUnicodeInterval* interval = &font->intervals[mid];
+        if (codepoint < interval->first) {
+            hi = mid - 1;
+        } else if (codepoint > interval->last) {
+            lo = mid + 1;
+        } else {
+            return &font->glyph[interval->offset + (codepoint - interval->first)];
+        }
+    }
+    return NULL;
+}
+
+const uint8_t* glyph_cache_get(const EpdFont* font, const EpdGlyph* glyph) {
+    if (!font->compressed || glyph->compressed_size == 0) {
+        return font->bitmap + glyph->data_offset; // 未压缩字体和字体包中原样存放的字形
+    }
+    if (bitmap_size(glyph) == 0) {
+        return scratch; // 空格等没有像素的字形
+    }
+
+    uint32_t bucket = bucket_of(font, glyph);
+    for (uint16_t i = buckets[bucket]; i != NONE; i = entries[i].hash_next) {
+        if (entries[i].font == font && entries[i].glyph == glyph) {
+            stats.hits++;
+            lru_unlink(i);
+            lru_append(i);
+            return arena + entries[i].block * GLYPH_CACHE_BLOCK;
+        }
+    }
+
+    stats.misses++;
+    uint32_t size = bitmap_size(glyph);
+    int blocks = (size + GLYPH_CACHE_BLOCK - 1) / GLYPH_CACHE_BLOCK;
+    int start = -1;
+    if (arena != NULL && blocks <= BLOCK_COUNT) {
+        while (free_head == NONE && evict_one()) {
+        }
+        while ((start = find_blocks(blocks)) < 0 && evict_one()) {
+        }
+    }
+    if (start < 0 || free_head == NONE) {
+        // 不缓存，临时解压
+        if (size > sizeof(scratch) || !inflate_glyph(font, glyph, scratch)) {
+            stats.errors++;
+            return NULL;
+        }
+        return scratch;
+    }
+
+    uint8_t* bitmap = arena + start * GLYPH_CACHE_BLOCK;
+    if (!inflate_glyph(font, glyph, bitmap)) {
+        stats.errors++;
+        return NULL;
+    }
+    uint16_t index = free_head;
+    glyph_entry_t* e = &entries[index];
+    free_head = e->hash_next;
+    e->font = font;
+    e->glyph = glyph;
+    e->block = start;
+    e->blocks = blocks;
+    e->hash_next = buckets[bucket];
+    buckets[bucket] = index;
+    lru_append(index);
+    mark_blocks(start, blocks, true);
+    stats.bytes_used += blocks * GLYPH_CACHE_BLOCK;
+    return bitmap;
+}
+
+void glyph_cache_get_stats(glyph_cache_stats_t* out) {
+    *out = stats;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 字形缓存：压缩字体的每个字形是一段独立的 zlib 数据（字体包中是 LZSS，见 font_pack.h；距离场字体在这里栅格化，
+// 见 font_sdf.h），解压后的4bpp位图按 (字体, 码点) 缓存在 PSRAM 中一块固定大小的区域里，空间不足时淘汰最久未使用的字形。只在显示任务中调用，不加锁
+#define GLYPH_CACHE_BYTES   (64 * 1024)
+#define GLYPH_CACHE_BLOCK   32  // 分配粒度
+#define GLYPH_CACHE_ENTRIES 512
+#define GLYPH_CACHE_BUCKETS 256
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;    // 需要解压的次数
+    uint32_t evictions;
+    uint32_t errors;    // 解压失败或位图放不进缓存
+    uint32_t bytes_used;
+} glyph_cache_stats_t;
+
+// 分配缓存区域，失败时 glyph_cache_get 每次都临时解压
+bool glyph_cache_init(void);
+
+// 丢弃所有缓存的字形（统计计数保留），之后的 glyph_cache_get 重新解压
+void glyph_cache_clear(void);
+
+// 查找码点对应的字形，字体中没有时返回 NULL。字体包查两级索引，其它字体二分查找码点区间
+const EpdGlyph* glyph_lookup(const EpdFont* font, uint32_t codepoint);
+
+// 字形的4bpp位图：每行 (width + 1) / 2 字节，低4位是偶数列。未压缩的字形直接返回字体数据。
+// 返回的指针在下一次调用前有效
+const uint8_t* glyph_cache_get(const EpdFont* font, const EpdGlyph* glyph);
+
+void glyph_cache_get_stats(glyph_cache_stats_t* stats);
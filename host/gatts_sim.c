@@ -0,0 +1,740 @@
+// 主机上的 GATTS 事件模拟器：直接编译 main.c 以及编解码/会话模块，
+// 把模拟的 Bluedroid 事件送进 gatts_profile_event_handler，测量协议改动的效果
+//
+// 构建：
+//   cmake -S host -B build-host && cmake --build build-host
+//
+// 合成模式（模拟器扮演发送端，流程与 image_converter_sender.py 相同）：
+//   build-host/gatts_sim [--payload FILE] [--mtu N] [--mode auto|control|bulk|long]
+//                        [--loss PCT] [--reorder PCT] [--interval-us N] [--kbps N]
+//                        [--disconnect-after N] [--images N] [--seed N] [--dump out.pgm] [--verbose]
+//                        [--fonts fonts.bin] [--text STR] [--no-mtu-reconnect]
+//   --fonts 为 font_partition.py 生成的 fonts 分区镜像；--text 在图像之后发送 IMAGE_OP_TEXT，
+//   文字用距离场字体排版绘制，--dump 输出文字画面；--no-mtu-reconnect 时重新连接后不交换 MTU（沿用默认的23），
+//   设备发出的读取应答和通知超出当前 MTU 时计入 att oversize，结果为失败；
+//   --payload 为 image_converter_sender.py --save-payload 生成的 [头信息][压缩数据]，
+//   不指定时使用 300x396 的未压缩测试图；--images 连续发送 N 张不同的测试图（幻灯片）
+//   control 和 bulk 模式每包至少携带一个块，MTU 分别不能小于 40 和 39；auto 在 MTU 较小时改用长写入
+//
+// 回放模式：
+//   build-host/gatts_sim --trace FILE [--dump out.pgm]
+//   FILE 为 image_converter_sender.py --trace-out 记录的真实会话，每行一个事件：
+//     <毫秒> connect <mtu> | <毫秒> disconnect | <毫秒> w|n <UUID> <十六进制数据> | <毫秒> r <UUID>
+//   订阅状态通知记录为对 2902 的写入
+//
+// 输出：有效吞吐（压缩数据字节/接收用时）、从第一个事件到图像写入帧缓冲区及刷新结束的模拟时间、
+// 面板刷新次数和主机CPU时间。模拟时钟由 delay() 和链路模型推进；面板刷新耗时为粗略估计，
+// 与显示任务一样和接收并行
+
+#include "../main.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define SIM_MAX_PAYLOAD (IMAGE_DELTA_BEGIN_LEN + RX_PAYLOAD_MAX)
+#define SIM_MAX_RETRIES 20
+#define LONG_WRITE_FRAME_MAX 512 // 属性值的最大长度，长写入一次最多携带这么多
+
+typedef enum { SIM_MODE_AUTO, SIM_MODE_CONTROL, SIM_MODE_BULK, SIM_MODE_LONG } sim_mode_t;
+
+static uint16_t sim_mtu = 247;
+static uint16_t sim_link_mtu = 23;      // 当前连接的 ATT_MTU，没有交换 MTU 时为默认的23
+static bool sim_mtu_on_reconnect = true; // 为 false 时重新连接后不交换 MTU
+static sim_mode_t sim_mode = SIM_MODE_AUTO;
+static int sim_loss = 0;       // 数据包丢失概率（百分比）
+static int sim_reorder = 0;    // 数据包与下一个交换顺序的概率（百分比）
+static int sim_interval_us = 7500;
+static int sim_kbps = 1000;    // 链路上的有效速率
+static int sim_disconnect_after = 0;
+static int sim_images = 1;
+static const char* sim_text = NULL; // 图像之后用 IMAGE_OP_TEXT 显示的文字
+
+static uint32_t sim_trans_id = 0;
+static bool sim_connected = false;
+static int sim_packets = 0;
+static int sim_dropped = 0;
+static int sim_connects = 0;
+static int sim_conn_packets = 0;
+static uint64_t sim_air_bytes = 0;
+static int64_t sim_start_us = -1;
+static int64_t sim_rx_done_us = -1;
+static int64_t sim_fb_us = -1;
+static int sim_displayed = 0;
+
+static uint8_t sim_frame[SIM_MAX_PAYLOAD];
+static uint8_t* sim_snapshot = NULL; // 图像刚显示时的帧缓冲区（之后的调试信息会覆盖屏幕）
+static uint32_t sim_header_len = 0;
+static uint32_t sim_payload_len = 0;
+
+// 一次ATT操作占用的链路时间：固定的连接事件间隔加上按速率计算的传输时间
+static void sim_link(uint32_t att_len) {
+    if (sim_start_us < 0) {
+        sim_start_us = host_time_us;
+    }
+    sim_air_bytes += att_len;
+    host_advance_us(sim_interval_us + (int64_t)(att_len + 7) * 8 * 1000 / sim_kbps);
+}
+
+// 相当于显示任务：面板空闲时执行队列中的下一批渲染命令，没有命令时做空闲维护
+static void sim_poll(void) {
+    if (host_time_us < host_panel_busy_until_us) {
+        return;
+    }
+    uint32_t displayed = images_displayed;
+    bool rendered = render_process_batch(0);
+    if (!rendered) {
+        display_idle();
+    }
+    panel_temp_poll();
+    if (rendered && images_displayed != displayed) {
+        sim_displayed += images_displayed - displayed;
+        sim_fb_us = host_last_update_us;
+        if (sim_snapshot == NULL) {
+            sim_snapshot = malloc(epd_width() * epd_height() / 2);
+        }
+        memcpy(sim_snapshot, epd_hl_get_framebuffer(&hl), epd_width() * epd_height() / 2);
+    }
+}
+
+// 分发一个事件；期间发出的通知同样占用链路时间
+static void sim_event(esp_gatts_cb_event_t event, esp_ble_gatts_cb_param_t* param) {
+    uint32_t notify_bytes = host_notify_bytes;
+    int notify_count = host_notify_count;
+    uint8_t stage = transfer_stage;
+    host_gatts_cb(event, image_profile_tab.gatts_if, param);
+    if (transfer_stage == TRANSFER_STAGE_DECODED && stage != TRANSFER_STAGE_DECODED) {
+        sim_rx_done_us = host_time_us;
+    }
+    sim_poll();
+    if (host_notify_count != notify_count) {
+        sim_air_bytes += host_notify_bytes - notify_bytes;
+        host_advance_us((int64_t)(host_notify_bytes - notify_bytes + 10 * (host_notify_count - notify_count)) * 8 *
+                        1000 / sim_kbps);
+    }
+}
+
+// 连接并交换 MTU；--no-mtu-reconnect 时只有第一次连接交换，之后的连接使用默认的 ATT_MTU
+static void sim_connect(uint16_t mtu) {
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.connect.conn_id = 0;
+    sim_link_mtu = 23;
+    host_att_mtu = sim_link_mtu;
+    sim_event(ESP_GATTS_CONNECT_EVT, &param);
+
+    if (sim_connects == 0 || sim_mtu_on_reconnect) {
+        memset(&param, 0, sizeof(param));
+        param.mtu.mtu = mtu;
+        sim_link_mtu = mtu;
+        host_att_mtu = sim_link_mtu;
+        sim_event(ESP_GATTS_MTU_EVT, &param);
+    }
+    sim_connected = true;
+    sim_connects++;
+    sim_conn_packets = 0;
+}
+
+static void sim_disconnect(void) {
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.disconnect.reason = 0x08;
+    sim_event(ESP_GATTS_DISCONNECT_EVT, &param);
+    sim_connected = false;
+}
+
+static esp_gatt_status_t sim_write_event(uint16_t handle, const uint8_t* value, uint16_t len, uint16_t offset,
+                                         bool need_rsp, bool is_prep) {
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.write.trans_id = ++sim_trans_id;
+    param.write.handle = handle;
+    param.write.offset = offset;
+    param.write.need_rsp = need_rsp;
+    param.write.is_prep = is_prep;
+    param.write.len = len;
+    param.write.value = (uint8_t*)value;
+    host_rsp_status = ESP_GATT_OK;
+    sim_link(3 + len + (is_prep ? 2 : 0));
+    sim_event(ESP_GATTS_WRITE_EVT, &param);
+    return host_rsp_status;
+}
+
+// 写入一个属性值；带应答且超过 MTU - 3 时像主机协议栈一样拆成长写入
+static bool sim_write(uint16_t handle, const uint8_t* value, uint32_t len, bool need_rsp) {
+    if (!need_rsp || len <= (uint32_t)sim_link_mtu - 3) {
+        return sim_write_event(handle, value, len, 0, need_rsp, false) == ESP_GATT_OK;
+    }
+
+    bool ok = true;
+    uint32_t fragment = sim_link_mtu - 5;
+    for (uint32_t offset = 0; offset < len && ok; offset += fragment) {
+        uint32_t n = len - offset < fragment ? len - offset : fragment;
+        ok = sim_write_event(handle, value + offset, n, offset, true, true) == ESP_GATT_OK;
+    }
+
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.exec_write.trans_id = ++sim_trans_id;
+    param.exec_write.exec_write_flag = ok ? ESP_GATT_PREP_WRITE_EXEC : ESP_GATT_PREP_WRITE_CANCEL;
+    sim_link(4);
+    sim_event(ESP_GATTS_EXEC_WRITE_EVT, &param);
+    return ok;
+}
+
+// 长读取一个属性值，返回长度
+static uint32_t sim_read(uint16_t handle, uint8_t* out, uint32_t max) {
+    uint32_t len = 0;
+    while (len < max) {
+        esp_ble_gatts_cb_param_t param;
+        memset(&param, 0, sizeof(param));
+        param.read.trans_id = ++sim_trans_id;
+        param.read.handle = handle;
+        param.read.offset = len;
+        param.read.is_long = len > 0;
+        param.read.need_rsp = true;
+        host_rsp_has_value = false;
+        sim_event(ESP_GATTS_READ_EVT, &param);
+        if (host_rsp_status != ESP_GATT_OK || !host_rsp_has_value) {
+            break;
+        }
+        uint16_t n = host_rsp.attr_value.len;
+        sim_link(1 + n);
+        if (n > max - len) {
+            n = max - len;
+        }
+        memcpy(out + len, host_rsp.attr_value.value, n);
+        len += n;
+        if (n < sim_link_mtu - 1) {
+            break;
+        }
+    }
+    return len;
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 查询缺失区间，返回 -1 表示会话与发送的内容不一致，0 表示已完成
+static int sim_missing(uint32_t hash, uint32_t* starts, uint32_t* lens, int max) {
+    int total = 0;
+    uint32_t cursor = 0;
+    for (;;) {
+        uint8_t query[5] = {IMAGE_OP_QUERY};
+        put_u32(query + 1, cursor);
+        sim_write(image_profile_tab.char_handle, query, sizeof(query), true);
+
+        uint8_t page[TRANSFER_STATUS_HEADER + TRANSFER_STATUS_RANGES_MAX * 8];
+        uint32_t len = sim_read(image_profile_tab.status_handle, page, sizeof(page));
+        if (len < TRANSFER_STATUS_HEADER || get_u32(page) != hash) {
+            return -1;
+        }
+        if (page[12] == TRANSFER_STATE_COMPLETE) {
+            return 0;
+        }
+        int count = page[14] | (page[15] << 8);
+        for (int i = 0; i < count && total < max; i++) {
+            starts[total] = get_u32(page + TRANSFER_STATUS_HEADER + i * 8);
+            lens[total] = get_u32(page + TRANSFER_STATUS_HEADER + i * 8 + 4);
+            total++;
+        }
+        if (count < TRANSFER_STATUS_RANGES_MAX || total >= max) {
+            return total;
+        }
+        cursor = starts[total - 1] + lens[total - 1];
+    }
+}
+
+typedef struct {
+    uint8_t data[LONG_WRITE_FRAME_MAX];
+    uint32_t len;
+} sim_packet_t;
+
+static sim_mode_t sim_effective_mode(void) {
+    if (sim_mode != SIM_MODE_AUTO) {
+        return sim_mode;
+    }
+    return sim_link_mtu < 185 ? SIM_MODE_LONG : SIM_MODE_BULK;
+}
+
+static void sim_deliver(const sim_packet_t* packet) {
+    sim_packets++;
+    sim_conn_packets++;
+    if (rand() % 100 < sim_loss) {
+        // 丢失的数据包仍然占用链路时间
+        sim_link(3 + packet->len);
+        sim_dropped++;
+    } else if (sim_effective_mode() == SIM_MODE_BULK) {
+        sim_write(image_profile_tab.bulk_handle, packet->data, packet->len, false);
+    } else {
+        sim_write(image_profile_tab.char_handle, packet->data, packet->len, true);
+    }
+    if (sim_disconnect_after > 0 && sim_conn_packets >= sim_disconnect_after) {
+        sim_disconnect();
+    }
+}
+
+// 每包携带的数据长度，按块对齐；MTU 放不下一个块时为0
+static uint32_t sim_chunk_size(void) {
+    sim_mode_t mode = sim_effective_mode();
+    if (mode == SIM_MODE_LONG) {
+        return (LONG_WRITE_FRAME_MAX - DATA_FRAME_HEADER) / RX_BLOCK_SIZE * RX_BLOCK_SIZE;
+    }
+    uint32_t prefix = mode == SIM_MODE_BULK ? 4 : DATA_FRAME_HEADER;
+    return ((sim_link_mtu < 500 ? sim_link_mtu : 500) - 3 - prefix) / RX_BLOCK_SIZE * RX_BLOCK_SIZE;
+}
+
+// 按块对齐分包发送区间，与 send_ranges 相同
+static void sim_send_ranges(const uint8_t* payload, const uint32_t* starts, const uint32_t* lens, int count) {
+    sim_mode_t mode = sim_effective_mode();
+    uint32_t chunk = sim_chunk_size();
+
+    sim_packet_t held = {0};
+    bool holding = false;
+    for (int r = 0; r < count && sim_connected; r++) {
+        for (uint32_t offset = starts[r]; offset < starts[r] + lens[r] && sim_connected; offset += chunk) {
+            uint32_t end = starts[r] + lens[r];
+            uint32_t n = end - offset < chunk ? end - offset : chunk;
+            sim_packet_t packet;
+            packet.len = 0;
+            if (mode != SIM_MODE_BULK) {
+                packet.data[packet.len++] = IMAGE_OP_DATA;
+            }
+            put_u32(packet.data + packet.len, offset);
+            packet.len += 4;
+            memcpy(packet.data + packet.len, payload + offset, n);
+            packet.len += n;
+
+            if (!holding && rand() % 100 < sim_reorder) {
+                held = packet;
+                holding = true;
+                continue;
+            }
+            sim_deliver(&packet);
+            if (holding && sim_connected) {
+                sim_deliver(&held);
+                holding = false;
+            }
+        }
+    }
+    if (holding && sim_connected) {
+        sim_deliver(&held);
+    }
+}
+
+// 发送头信息；设备的两块缓冲区都在等待显示时隔 0.5 秒重试
+static bool sim_begin(uint32_t hash) {
+    for (int i = 0; i < 60 && sim_connected; i++) {
+        sim_write(image_profile_tab.char_handle, sim_frame, sim_header_len, true);
+        uint8_t page[TRANSFER_STATUS_HEADER];
+        uint32_t len = sim_read(image_profile_tab.status_handle, page, sizeof(page));
+        if (len < TRANSFER_STATUS_HEADER || get_u32(page) == hash || page[16] != TRANSFER_ERROR_BUSY) {
+            return true;
+        }
+        host_advance_us(500000);
+        sim_poll();
+    }
+    return false;
+}
+
+// 按 image_converter_sender.py 的流程发送一张图像，断开后重连并补发缺失部分
+static bool sim_send_image(void) {
+    const uint8_t* payload = sim_frame + sim_header_len;
+    uint32_t hash = get_u32(sim_frame + 10);
+    static uint32_t starts[4096];
+    static uint32_t lens[4096];
+
+    for (int attempt = 0; attempt <= SIM_MAX_RETRIES; attempt++) {
+        if (attempt > 0) {
+            host_advance_us(1000000); // 与发送端一样等待1秒后重连
+        }
+        sim_connect(sim_mtu);
+        const uint8_t subscribe[2] = {0x01, 0x00};
+        sim_write(image_profile_tab.status_cccd_handle, subscribe, sizeof(subscribe), true);
+        if (!sim_begin(hash)) {
+            continue;
+        }
+        for (int round = 0; round < 5 && sim_connected; round++) {
+            int count = sim_missing(hash, starts, lens, 4096);
+            if (count == 0) {
+                sim_disconnect();
+                return true;
+            }
+            if (count < 0) {
+                starts[0] = 0;
+                lens[0] = sim_payload_len;
+                count = 1;
+            }
+            sim_send_ranges(payload, starts, lens, count);
+        }
+        if (sim_connected) {
+            sim_disconnect();
+            return false;
+        }
+    }
+    return false;
+}
+
+static void sim_make_test_image(int variant);
+
+// 合成模式：依次发送每张图像（不等待显示），最后等待面板显示完全部图像
+static bool sim_run_sender(void) {
+    for (int i = 0; i < sim_images; i++) {
+        if (i > 0) {
+            sim_make_test_image(i);
+        }
+        if (!sim_send_image()) {
+            return false;
+        }
+    }
+    while (sim_displayed < sim_images && host_panel_busy_until_us > host_time_us) {
+        host_time_us = host_panel_busy_until_us;
+        sim_poll();
+    }
+    return sim_displayed == sim_images;
+}
+
+// 发送 IMAGE_OP_TEXT 并等到文字整屏刷新，之后 --dump 输出文字画面
+static bool sim_send_text(void) {
+    uint8_t frame[1 + RENDER_TEXT_MAX];
+    uint32_t len = strlen(sim_text);
+    if (len > RENDER_TEXT_MAX - 1) {
+        len = RENDER_TEXT_MAX - 1; // 与发送端一样截断（这里不处理 UTF-8 边界，由设备处理）
+    }
+    frame[0] = IMAGE_OP_TEXT;
+    memcpy(frame + 1, sim_text, len);
+    int updates = host_screen_updates;
+    sim_connect(sim_mtu); // 与 image_converter_sender.py --text 一样单独连接一次
+    bool written = sim_write(image_profile_tab.char_handle, frame, len + 1, true);
+    sim_disconnect();
+    if (!written) {
+        return false;
+    }
+    for (int i = 0; i < 100 && host_screen_updates == updates; i++) {
+        host_time_us = host_panel_busy_until_us > host_time_us ? host_panel_busy_until_us : host_time_us + 10000;
+        sim_poll();
+    }
+    free(sim_snapshot);
+    sim_snapshot = NULL;
+    return host_screen_updates > updates;
+}
+
+static uint16_t sim_uuid_handle(unsigned uuid) {
+    switch (uuid) {
+    case GATTS_CHAR_UUID_IMAGE_DATA:
+        return image_profile_tab.char_handle;
+    case GATTS_CHAR_UUID_TILE_HASH:
+        return image_profile_tab.hash_handle;
+    case GATTS_CHAR_UUID_STATUS:
+        return image_profile_tab.status_handle;
+    case GATTS_CHAR_UUID_BULK_DATA:
+        return image_profile_tab.bulk_handle;
+    case ESP_GATT_UUID_CHAR_CLIENT_CONFIG:
+        return image_profile_tab.status_cccd_handle;
+    default:
+        return 0;
+    }
+}
+
+static uint32_t sim_parse_hex(const char* hex, uint8_t* out, uint32_t max) {
+    uint32_t len = 0;
+    while (hex[0] && hex[1] && len < max) {
+        unsigned byte;
+        if (sscanf(hex, "%2x", &byte) != 1) {
+            break;
+        }
+        out[len++] = byte;
+        hex += 2;
+    }
+    return len;
+}
+
+// 回放模式：按记录的时间戳推进时钟并重放事件，链路时间取记录值
+static bool sim_run_trace(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    static char line[4 * LONG_WRITE_FRAME_MAX];
+    static uint8_t value[2 * LONG_WRITE_FRAME_MAX];
+    int64_t base_us = host_time_us;
+    int lineno = 0;
+    sim_interval_us = 0;
+    sim_kbps = 1 << 30;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        double t_ms;
+        char op[16];
+        char arg[16];
+        int consumed = 0;
+        if (sscanf(line, "%lf %15s%n", &t_ms, op, &consumed) < 2) {
+            continue;
+        }
+        int64_t t_us = base_us + (int64_t)(t_ms * 1000);
+        if (t_us > host_time_us) {
+            host_time_us = t_us;
+        }
+
+        const char* rest = line + consumed;
+        if (strcmp(op, "connect") == 0) {
+            int mtu = 23;
+            sscanf(rest, "%d", &mtu);
+            sim_mtu = mtu;
+            sim_connect(sim_mtu);
+        } else if (strcmp(op, "disconnect") == 0) {
+            sim_disconnect();
+        } else if ((strcmp(op, "w") == 0 || strcmp(op, "n") == 0 || strcmp(op, "r") == 0) &&
+                   sscanf(rest, "%15s%n", arg, &consumed) == 1) {
+            uint16_t handle = sim_uuid_handle(strtoul(arg, NULL, 16));
+            if (handle == 0) {
+                fprintf(stderr, "%s:%d: unknown characteristic %s\n", path, lineno, arg);
+                continue;
+            }
+            if (op[0] == 'r') {
+                sim_read(handle, value, sizeof(value));
+            } else {
+                char hex[sizeof(line)];
+                hex[0] = '\0';
+                sscanf(rest + consumed, "%s", hex);
+                uint32_t len = sim_parse_hex(hex, value, sizeof(value));
+                if (sim_start_us < 0 && len >= IMAGE_BEGIN_LEN &&
+                    (value[0] == IMAGE_OP_BEGIN || value[0] == IMAGE_OP_DELTA_BEGIN)) {
+                    sim_payload_len = get_u32(value + 6);
+                }
+                sim_write(handle, value, len, op[0] == 'w');
+            }
+        } else {
+            fprintf(stderr, "%s:%d: unknown event %s\n", path, lineno, op);
+        }
+    }
+    fclose(f);
+    while (host_panel_busy_until_us > host_time_us) {
+        host_time_us = host_panel_busy_until_us;
+        sim_poll();
+    }
+    return sim_fb_us >= 0;
+}
+
+// 未指定数据文件时生成未压缩的测试图：水平灰阶加若干矩形，variant 改变矩形的位置
+static void sim_make_test_image(int variant) {
+    const uint16_t w = 300, h = 396;
+    uint8_t* image = sim_frame + IMAGE_BEGIN_LEN;
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x += 2) {
+            uint8_t c0 = x * 16 / w;
+            uint8_t c1 = (x + 1) * 16 / w;
+            if ((y / 48 + variant) % 2 == 1 && (x / 60) % 2 == 0) {
+                c0 = c1 = 15 - c0;
+            }
+            image[(y * w + x) / 2] = (c0 << 4) | c1;
+        }
+    }
+    sim_payload_len = w * h / 2;
+    sim_header_len = IMAGE_BEGIN_LEN;
+    sim_frame[0] = IMAGE_OP_BEGIN;
+    put_u16(sim_frame + 1, w);
+    put_u16(sim_frame + 3, h);
+    sim_frame[5] = IMAGE_ENCODING_RAW;
+    put_u32(sim_frame + 6, sim_payload_len);
+    put_u32(sim_frame + 10, rx_hash(image, sim_payload_len));
+}
+
+static bool sim_load_payload(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    size_t len = fread(sim_frame, 1, sizeof(sim_frame), f);
+    fclose(f);
+    if (len < IMAGE_BEGIN_LEN || sim_frame[0] != IMAGE_OP_BEGIN) {
+        // 增量传输依赖设备上已显示的图像，这里只支持完整图像
+        fprintf(stderr, "%s: expected a full-image BEGIN frame\n", path);
+        return false;
+    }
+    sim_header_len = IMAGE_BEGIN_LEN;
+    sim_payload_len = get_u32(sim_frame + 6);
+    if (len != sim_header_len + sim_payload_len) {
+        fprintf(stderr, "%s: payload size mismatch\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void sim_dump_pgm(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    int w = epd_width();
+    int h = epd_height();
+    const uint8_t* fb = sim_snapshot != NULL ? sim_snapshot : epd_hl_get_framebuffer(&hl);
+    fprintf(f, "P5\n%d %d\n255\n", w, h);
+    for (int i = 0; i < w * h / 2; i++) {
+        fputc((fb[i] & 0x0F) * 17, f);
+        fputc((fb[i] >> 4) * 17, f);
+    }
+    fclose(f);
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--payload FILE | --trace FILE] [--mtu N] [--mode auto|control|bulk|long]\n"
+            "          [--loss PCT] [--reorder PCT] [--interval-us N] [--kbps N]\n"
+            "          [--disconnect-after N] [--images N] [--seed N] [--dump out.pgm] [--verbose]\n"
+            "          [--fonts fonts.bin] [--text STR] [--no-mtu-reconnect]\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    const char* payload_path = NULL;
+    const char* trace_path = NULL;
+    const char* dump_path = NULL;
+    unsigned seed = 1;
+    host_quiet = true;
+
+    for (int i = 1; i < argc; i++) {
+        const char* opt = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(opt, "--verbose") == 0) {
+            host_quiet = false;
+            continue;
+        }
+        if (strcmp(opt, "--no-mtu-reconnect") == 0) {
+            sim_mtu_on_reconnect = false;
+            continue;
+        }
+        if (val == NULL) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (strcmp(opt, "--payload") == 0) {
+            payload_path = val;
+        } else if (strcmp(opt, "--trace") == 0) {
+            trace_path = val;
+        } else if (strcmp(opt, "--dump") == 0) {
+            dump_path = val;
+        } else if (strcmp(opt, "--fonts") == 0) {
+            host_font_image = val;
+        } else if (strcmp(opt, "--mtu") == 0) {
+            sim_mtu = atoi(val);
+        } else if (strcmp(opt, "--mode") == 0) {
+            sim_mode = strcmp(val, "control") == 0 ? SIM_MODE_CONTROL
+                       : strcmp(val, "bulk") == 0  ? SIM_MODE_BULK
+                       : strcmp(val, "long") == 0  ? SIM_MODE_LONG
+                                                   : SIM_MODE_AUTO;
+        } else if (strcmp(opt, "--loss") == 0) {
+            sim_loss = atoi(val);
+        } else if (strcmp(opt, "--reorder") == 0) {
+            sim_reorder = atoi(val);
+        } else if (strcmp(opt, "--interval-us") == 0) {
+            sim_interval_us = atoi(val);
+        } else if (strcmp(opt, "--kbps") == 0) {
+            sim_kbps = atoi(val);
+        } else if (strcmp(opt, "--disconnect-after") == 0) {
+            sim_disconnect_after = atoi(val);
+        } else if (strcmp(opt, "--text") == 0) {
+            sim_text = val;
+        } else if (strcmp(opt, "--images") == 0) {
+            sim_images = atoi(val);
+        } else if (strcmp(opt, "--seed") == 0) {
+            seed = strtoul(val, NULL, 0);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (sim_mtu < 23 || sim_mtu > 517 || sim_kbps <= 0 || sim_images < 1 || (payload_path && sim_images > 1)) {
+        usage(argv[0]);
+        return 2;
+    }
+    // 会话只标记被完整覆盖的块，不对齐的包永远不会被计入。重新连接后不交换 MTU 时还要检查默认的 ATT_MTU
+    sim_link_mtu = sim_mtu;
+    bool fits = sim_chunk_size() > 0;
+    if (!sim_mtu_on_reconnect) {
+        sim_link_mtu = 23;
+        fits = fits && sim_chunk_size() > 0;
+    }
+    if (trace_path == NULL && !fits) {
+        fprintf(stderr, "mtu %u cannot carry a %d-byte block in this mode, use --mode long or auto\n", sim_link_mtu,
+                RX_BLOCK_SIZE);
+        return 2;
+    }
+    srand(seed);
+
+    if (payload_path != NULL) {
+        if (!sim_load_payload(payload_path)) {
+            return 1;
+        }
+    } else if (trace_path == NULL) {
+        sim_make_test_image(0);
+    }
+
+    clock_t cpu_start = clock();
+    idf_setup();
+    while (render_process_batch(0)) {
+        // 启动时的调试信息
+    }
+    panel_power_off();
+    host_time_us = 0;
+    host_panel_busy_until_us = 0;
+    host_screen_updates = 0;
+    host_area_updates = 0;
+    host_power_ups = 0;
+    host_temperature_reads = 0;
+
+    bool ok = trace_path != NULL ? sim_run_trace(trace_path) : sim_run_sender();
+    bool text_ok = sim_text == NULL || (ok && sim_send_text());
+    double cpu_ms = (double)(clock() - cpu_start) * 1000 / CLOCKS_PER_SEC;
+
+    printf("result        %s\n", ok && sim_fb_us >= 0 ? "displayed" : "FAILED");
+    if (trace_path == NULL) {
+        const char* modes[] = {"auto", "control", "bulk", "long"};
+        printf("payload       %" PRIu32 " bytes, encoding %u\n", sim_payload_len, sim_frame[5]);
+        printf("link          mtu %u, %s, interval %d us, %d kbps\n", sim_mtu, modes[sim_effective_mode()],
+               sim_interval_us, sim_kbps);
+        printf("packets       %d sent, %d dropped, %d connections\n", sim_packets, sim_dropped, sim_connects);
+        printf("images        %d/%d displayed\n", sim_displayed, sim_images);
+    }
+    if (sim_text != NULL) {
+        printf("text          %s\n", text_ok ? "displayed" : "FAILED");
+    }
+    printf("att bytes     %" PRIu64 " (%d status notifications)\n", sim_air_bytes, host_notify_count);
+    printf("att oversize  %d responses/notifications larger than the link MTU\n", host_att_oversize);
+    if (sim_rx_done_us > sim_start_us && sim_start_us >= 0) {
+        double rx_ms = (sim_rx_done_us - sim_start_us) / 1000.0;
+        printf("receive       %.1f ms, %.0f payload bytes/s\n", rx_ms,
+               (double)sim_payload_len * sim_images * 1000.0 / rx_ms);
+    }
+    if (sim_fb_us >= 0 && sim_start_us >= 0) {
+        printf("framebuffer   %.1f ms after first event\n", (sim_fb_us - sim_start_us) / 1000.0);
+        printf("refresh done  %.1f ms after first event\n", (host_panel_busy_until_us - sim_start_us) / 1000.0);
+    }
+    printf("panel         %d full updates, %d area updates\n", host_screen_updates, host_area_updates);
+    panel_power_stats_t power;
+    panel_power_get_stats(&power);
+    printf("panel power   %d power-ups, %" PRIu32 "/%" PRIu32 " updates already powered\n", host_power_ups,
+           power.warm_acquires, power.acquires);
+    printf("temperature   %d sensor reads\n", host_temperature_reads);
+    ghost_budget_stats_t ghost;
+    ghost_budget_get_stats(&ghost);
+    printf("ghosting      %" PRIu32 " charged updates, %" PRIu32 " clean refreshes (%" PRIu32 " regions)\n",
+           ghost.charges, ghost.cleans, ghost.cleaned_area);
+    glyph_cache_stats_t glyphs;
+    glyph_cache_get_stats(&glyphs);
+    printf("glyph cache   %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " evictions, %" PRIu32 " bytes\n",
+           glyphs.hits, glyphs.misses, glyphs.evictions, glyphs.bytes_used);
+    text_layout_stats_t layouts;
+    text_layout_get_stats(&layouts);
+    printf("text layout   %" PRIu32 " hits, %" PRIu32 " misses\n", layouts.hits, layouts.misses);
+    printf("host cpu      %.1f ms\n", cpu_ms);
+
+    if (dump_path != NULL) {
+        sim_dump_pgm(dump_path);
+    }
+    return ok && text_ok && host_att_oversize == 0 ? 0 : 1;
+}
@@ -0,0 +1,750 @@
+#include "host_stubs.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+// 面板刷新耗时的粗略估计。刷新在显示任务中阻塞，不推进全局时钟，只记录面板忙到何时
+#define HOST_FULL_REFRESH_US 1200000
+#define HOST_AREA_REFRESH_US 450000
+#define HOST_CLEAR_US        1800000
+#define HOST_POWER_UP_US     20000 // 面板电源上电后稳定的时间
+#define HOST_TEMP_READ_US    5000  // 通过 I2C 读取一次温度
+
+#define HOST_EPD_WIDTH  1448
+#define HOST_EPD_HEIGHT 1072
+
+int64_t host_time_us = 0;
+esp_gatts_cb_t host_gatts_cb = NULL;
+esp_gap_ble_cb_t host_gap_cb = NULL;
+esp_gatt_status_t host_rsp_status = ESP_GATT_OK;
+esp_gatt_rsp_t host_rsp;
+bool host_rsp_has_value = false;
+uint16_t host_att_mtu = 23;
+int host_att_oversize = 0;
+int host_notify_count = 0;
+uint32_t host_notify_bytes = 0;
+int host_screen_updates = 0;
+int host_area_updates = 0;
+int64_t host_last_update_us = 0;
+int64_t host_panel_busy_until_us = 0;
+bool host_panel_power = false;
+int host_power_ups = 0;
+int host_temperature_reads = 0;
+bool host_quiet = false;
+const char* host_font_image = NULL;
+
+const EpdWaveform epdiy_ED060SCT = {0};
+const EpdBoardDefinition epd_board_v6 = {0};
+const EpdBoardDefinition epd_board_v7 = {0};
+
+void host_advance_us(int64_t us) {
+    host_time_us += us;
+}
+
+static void host_panel_busy(int64_t us) {
+    int64_t start = host_panel_busy_until_us > host_time_us ? host_panel_busy_until_us : host_time_us;
+    host_panel_busy_until_us = start + us;
+}
+
+void host_log(char level, const char* tag, const char* fmt, ...) {
+    if (host_quiet) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%c (%lld) %s: ", level, (long long)(host_time_us / 1000), tag);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+// ---- heap / timer / FreeRTOS / Arduino ----
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    (void)caps;
+    return calloc(n, size);
+}
+
+void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+void heap_caps_print_heap_info(uint32_t caps) {
+    (void)caps;
+}
+
+int64_t esp_timer_get_time(void) {
+    return host_time_us;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    host_advance_us((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(host_time_us / 1000 / portTICK_PERIOD_MS);
+}
+
+static int host_task_notify = 0;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)stack;
+    (void)priority;
+    (void)core;
+    if (handle != NULL) {
+        *handle = NULL;
+    }
+    if (strcmp(name, "display") != 0) {
+        task(arg);
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return NULL;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+    host_task_notify++;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+    (void)wait;
+    uint32_t value = host_task_notify;
+    host_task_notify = clear ? 0 : (value > 0 ? value - 1 : 0);
+    return value;
+}
+
+struct host_queue {
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t* items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->items = malloc(length * item_size);
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait) {
+    (void)wait;
+    if (queue->count == queue->length) {
+        return pdFALSE;
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait) {
+    (void)wait;
+    if (queue->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->count;
+}
+
+esp_err_t gpio_set_direction(int gpio, gpio_mode_t mode) {
+    (void)gpio;
+    (void)mode;
+    return ESP_OK;
+}
+
+// 只有面板电源一个输出：上电时面板要等电压稳定后才能刷新
+esp_err_t gpio_set_level(int gpio, uint32_t level) {
+    (void)gpio;
+    if (level && !host_panel_power) {
+        host_power_ups++;
+        host_panel_busy(HOST_POWER_UP_US);
+    }
+    host_panel_power = level != 0;
+    return ESP_OK;
+}
+
+void delay(uint32_t ms) {
+    host_advance_us((int64_t)ms * 1000);
+}
+
+// ---- NVS：进程内的几条记录 ----
+#define HOST_NVS_SLOTS 8
+static struct {
+    char key[16];
+    uint8_t* value;
+    size_t len;
+} host_nvs[HOST_NVS_SLOTS];
+
+static int host_nvs_find(const char* key) {
+    for (int i = 0; i < HOST_NVS_SLOTS; i++) {
+        if (host_nvs[i].value != NULL && strcmp(host_nvs[i].key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    for (int i = 0; i < HOST_NVS_SLOTS; i++) {
+        free(host_nvs[i].value);
+        host_nvs[i].value = NULL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {
+    (void)name;
+    (void)mode;
+    *handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* len) {
+    (void)handle;
+    int i = host_nvs_find(key);
+    if (i < 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out != NULL) {
+        memcpy(out, host_nvs[i].value, *len < host_nvs[i].len ? *len : host_nvs[i].len);
+    }
+    *len = host_nvs[i].len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t len) {
+    (void)handle;
+    int i = host_nvs_find(key);
+    if (i < 0) {
+        for (i = 0; i < HOST_NVS_SLOTS && host_nvs[i].value != NULL; i++) {
+        }
+        if (i == HOST_NVS_SLOTS) {
+            return ESP_ERR_NVS_NO_FREE_PAGES;
+        }
+        snprintf(host_nvs[i].key, sizeof(host_nvs[i].key), "%s", key);
+    }
+    free(host_nvs[i].value);
+    host_nvs[i].value = malloc(len > 0 ? len : 1);
+    memcpy(host_nvs[i].value, value, len);
+    host_nvs[i].len = len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    (void)handle;
+    int i = host_nvs_find(key);
+    if (i < 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    free(host_nvs[i].value);
+    host_nvs[i].value = NULL;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+// ---- BT controller / Bluedroid：事件同步分发到注册的回调 ----
+#define HOST_GATTS_IF 3
+static uint16_t host_next_handle = 40;
+
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode) {
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t* cfg) {
+    (void)cfg;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode) {
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_bluedroid_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t esp_bluedroid_enable(void) {
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback) {
+    host_gatts_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_app_register(uint16_t app_id) {
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.reg.status = ESP_GATT_OK;
+    param.reg.app_id = app_id;
+    host_gatts_cb(ESP_GATTS_REG_EVT, HOST_GATTS_IF, &param);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_create_service(esp_gatt_if_t gatts_if, esp_gatt_srvc_id_t* service_id, uint16_t num_handle) {
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.create.service_handle = host_next_handle;
+    param.create.service_id = *service_id;
+    host_next_handle += 1;
+    (void)num_handle;
+    host_gatts_cb(ESP_GATTS_CREATE_EVT, gatts_if, &param);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_add_char(uint16_t service_handle, esp_bt_uuid_t* char_uuid, esp_gatt_perm_t perm,
+                                 esp_gatt_char_prop_t property, esp_attr_value_t* char_val, esp_attr_control_t* control) {
+    (void)perm;
+    (void)property;
+    (void)char_val;
+    (void)control;
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    // 特征声明占一个句柄，值句柄紧随其后
+    param.add_char.attr_handle = host_next_handle + 1;
+    param.add_char.service_handle = service_handle;
+    param.add_char.char_uuid = *char_uuid;
+    host_next_handle += 2;
+    host_gatts_cb(ESP_GATTS_ADD_CHAR_EVT, HOST_GATTS_IF, &param);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_add_char_descr(uint16_t service_handle, esp_bt_uuid_t* descr_uuid, esp_gatt_perm_t perm,
+                                       esp_attr_value_t* char_descr_val, esp_attr_control_t* control) {
+    (void)perm;
+    (void)char_descr_val;
+    (void)control;
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.add_char_descr.attr_handle = host_next_handle;
+    param.add_char_descr.service_handle = service_handle;
+    param.add_char_descr.descr_uuid = *descr_uuid;
+    host_next_handle += 1;
+    host_gatts_cb(ESP_GATTS_ADD_CHAR_DESCR_EVT, HOST_GATTS_IF, &param);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_start_service(uint16_t service_handle) {
+    esp_ble_gatts_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.start.service_handle = service_handle;
+    host_gatts_cb(ESP_GATTS_START_EVT, HOST_GATTS_IF, &param);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id, uint32_t trans_id,
+                                      esp_gatt_status_t status, esp_gatt_rsp_t* rsp) {
+    (void)gatts_if;
+    (void)conn_id;
+    (void)trans_id;
+    host_rsp_status = status;
+    host_rsp_has_value = rsp != NULL;
+    if (rsp != NULL) {
+        host_rsp = *rsp;
+        if (rsp->attr_value.len > host_att_mtu - 1) {
+            host_att_oversize++;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                      uint16_t value_len, uint8_t* value, bool need_confirm) {
+    (void)gatts_if;
+    (void)conn_id;
+    (void)attr_handle;
+    (void)value;
+    (void)need_confirm;
+    if (value_len > host_att_mtu - 3) {
+        host_att_oversize++; // 协议栈不会发出超出 MTU 的通知
+        return ESP_FAIL;
+    }
+    host_notify_count++;
+    host_notify_bytes += value_len;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu) {
+    (void)mtu;
+    return ESP_OK;
+}
+
+// ---- GAP ----
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback) {
+    host_gap_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t* params) {
+    (void)params;
+    if (host_gap_cb != NULL) {
+        esp_ble_gap_cb_param_t param = {.adv_start_cmpl = {.status = ESP_BT_STATUS_SUCCESS}};
+        host_gap_cb(ESP_GAP_BLE_ADV_START_COMPLETE_EVT, &param);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_device_name(const char* name) {
+    (void)name;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_config_adv_data(esp_ble_adv_data_t* data) {
+    (void)data;
+    if (host_gap_cb != NULL) {
+        esp_ble_gap_cb_param_t param = {.adv_data_cmpl = {.status = ESP_BT_STATUS_SUCCESS}};
+        host_gap_cb(ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT, &param);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t* params) {
+    (void)params;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_pkt_data_len(esp_bd_addr_t remote_device, uint16_t tx_data_length) {
+    (void)remote_device;
+    (void)tx_data_length;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_preferred_phy(esp_bd_addr_t bd_addr, uint8_t all_phys_mask, uint8_t tx_phy_mask,
+                                        uint8_t rx_phy_mask, uint16_t phy_options) {
+    (void)bd_addr;
+    (void)all_phys_mask;
+    (void)tx_phy_mask;
+    (void)rx_phy_mask;
+    (void)phy_options;
+    return ESP_OK;
+}
+
+// ---- epdiy：只维护帧缓冲区，刷新只计数并推进时钟 ----
+static enum EpdRotation host_rotation = EPD_ROT_LANDSCAPE;
+static uint8_t* host_framebuffer = NULL;
+
+void epd_init(const EpdBoardDefinition* board, const EpdDisplay_t* display, enum EpdInitOptions options) {
+    (void)board;
+    (void)display;
+    (void)options;
+}
+
+void epd_set_vcom(uint16_t vcom) {
+    (void)vcom;
+}
+
+EpdiyHighlevelState epd_hl_init(const EpdWaveform* waveform) {
+    EpdiyHighlevelState state;
+    memset(&state, 0, sizeof(state));
+    host_framebuffer = malloc(HOST_EPD_WIDTH * HOST_EPD_HEIGHT / 2);
+    memset(host_framebuffer, 0xFF, HOST_EPD_WIDTH * HOST_EPD_HEIGHT / 2);
+    state.front_fb = host_framebuffer;
+    state.back_fb = malloc(HOST_EPD_WIDTH * HOST_EPD_HEIGHT / 2);
+    memset(state.back_fb, 0xFF, HOST_EPD_WIDTH * HOST_EPD_HEIGHT / 2);
+    state.waveform = waveform;
+    return state;
+}
+
+uint8_t* epd_hl_get_framebuffer(EpdiyHighlevelState* state) {
+    return state->front_fb;
+}
+
+void epd_hl_set_all_white(EpdiyHighlevelState* state) {
+    memset(state->front_fb, 0xFF, HOST_EPD_WIDTH * HOST_EPD_HEIGHT / 2);
+}
+
+enum EpdDrawError epd_hl_update_screen(EpdiyHighlevelState* state, enum EpdDrawMode mode, int temperature) {
+    (void)state;
+    (void)mode;
+    (void)temperature;
+    host_screen_updates++;
+    host_last_update_us = host_time_us;
+    host_panel_busy(HOST_FULL_REFRESH_US);
+    return EPD_DRAW_SUCCESS;
+}
+
+enum EpdDrawError epd_hl_update_area(EpdiyHighlevelState* state, enum EpdDrawMode mode, int temperature, EpdRect area) {
+    (void)state;
+    (void)mode;
+    (void)temperature;
+    (void)area;
+    host_area_updates++;
+    host_last_update_us = host_time_us;
+    host_panel_busy(HOST_AREA_REFRESH_US);
+    return EPD_DRAW_SUCCESS;
+}
+
+void epd_set_rotation(enum EpdRotation rotation) {
+    host_rotation = rotation;
+}
+
+enum EpdRotation epd_get_rotation(void) {
+    return host_rotation;
+}
+
+int epd_width(void) {
+    return HOST_EPD_WIDTH;
+}
+
+int epd_height(void) {
+    return HOST_EPD_HEIGHT;
+}
+
+int epd_rotated_display_width(void) {
+    return host_rotation == EPD_ROT_LANDSCAPE || host_rotation == EPD_ROT_INVERTED_LANDSCAPE ? HOST_EPD_WIDTH
+                                                                                            : HOST_EPD_HEIGHT;
+}
+
+int epd_rotated_display_height(void) {
+    return host_rotation == EPD_ROT_LANDSCAPE || host_rotation == EPD_ROT_INVERTED_LANDSCAPE ? HOST_EPD_HEIGHT
+                                                                                            : HOST_EPD_WIDTH;
+}
+
+// 读取期间显示任务不能开始刷新
+int epd_ambient_temperature(void) {
+    host_temperature_reads++;
+    host_panel_busy(HOST_TEMP_READ_US);
+    return 22;
+}
+
+void epd_clear(void) {
+    host_panel_busy(HOST_CLEAR_US);
+}
+
+void epd_fullclear(EpdiyHighlevelState* state, int temperature) {
+    (void)temperature;
+    epd_hl_set_all_white(state);
+    host_panel_busy(HOST_CLEAR_US);
+}
+
+void epd_clear_area(EpdRect area) {
+    (void)area;
+    host_panel_busy(HOST_CLEAR_US);
+}
+
+// 与 epdiy 一致：横向时偶数 x 在低4位
+void epd_draw_pixel(int x, int y, uint8_t color, uint8_t* framebuffer) {
+    int w = epd_rotated_display_width();
+    int h = epd_rotated_display_height();
+    if (x < 0 || x >= w || y < 0 || y >= h) {
+        return;
+    }
+    switch (host_rotation) {
+    case EPD_ROT_PORTRAIT: {
+        int t = x;
+        x = HOST_EPD_WIDTH - 1 - y;
+        y = t;
+        break;
+    }
+    case EPD_ROT_INVERTED_LANDSCAPE:
+        x = HOST_EPD_WIDTH - 1 - x;
+        y = HOST_EPD_HEIGHT - 1 - y;
+        break;
+    case EPD_ROT_INVERTED_PORTRAIT: {
+        int t = x;
+        x = y;
+        y = HOST_EPD_HEIGHT - 1 - t;
+        break;
+    }
+    default:
+        break;
+    }
+    uint8_t* p = &framebuffer[y * HOST_EPD_WIDTH / 2 + x / 2];
+    if (x % 2) {
+        *p = (*p & 0x0F) | (color & 0xF0);
+    } else {
+        *p = (*p & 0xF0) | (color >> 4);
+    }
+}
+
+void epd_fill_rect(EpdRect rect, uint8_t color, uint8_t* framebuffer) {
+    for (int y = rect.y; y < rect.y + rect.height; y++) {
+        for (int x = rect.x; x < rect.x + rect.width; x++) {
+            epd_draw_pixel(x, y, color, framebuffer);
+        }
+    }
+}
+
+EpdFontProperties epd_font_properties_default(void) {
+    EpdFontProperties props = {.fg_color = 0, .bg_color = 15, .fallback_glyph = 0, .flags = EPD_DRAW_ALIGN_LEFT};
+    return props;
+}
+
+// 与 epdiy 的 epd_write_string 相同的做法，作为文字绘制的基准：每个字形按码点区间查找，压缩字体逐个解压到
+// 临时缓冲区，再逐像素 epd_draw_pixel。只支持左对齐和 '\n'，不认识字体包和距离场字体
+static const EpdGlyph* host_get_glyph(const EpdFont* font, uint32_t cp) {
+    for (uint32_t i = 0; i < font->interval_count; i++) {
+        const EpdUnicodeInterval* interval = &font->intervals[i];
+        if (cp >= interval->first && cp <= interval->last) {
+            return &font->glyph[interval->offset + (cp - interval->first)];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t host_next_codepoint(const char** string) {
+    const uint8_t* s = (const uint8_t*)*string;
+    int extra = s[0] < 0x80 ? 0 : (s[0] & 0xE0) == 0xC0 ? 1 : (s[0] & 0xF0) == 0xE0 ? 2 : 3;
+    uint32_t cp = extra == 0 ? s[0] : s[0] & (0x3F >> extra);
+    int i = 1;
+    for (; i <= extra && (s[i] & 0xC0) == 0x80; i++) {
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    *string += i;
+    return cp;
+}
+
+enum EpdDrawError epd_write_string(const EpdFont* font, const char* string, int* cursor_x, int* cursor_y,
+                                   uint8_t* framebuffer, const EpdFontProperties* properties) {
+    EpdFontProperties props = properties != NULL ? *properties : epd_font_properties_default();
+    bool background = props.flags & EPD_DRAW_BACKGROUND;
+    uint8_t color_lut[16];
+    for (int c = 0; c < 16; c++) {
+        color_lut[c] = props.bg_color + c * ((int)props.fg_color - (int)props.bg_color) / 15;
+    }
+    enum EpdDrawError err = EPD_DRAW_SUCCESS;
+    int line_start = *cursor_x;
+    while (*string) {
+        uint32_t cp = host_next_codepoint(&string);
+        if (cp == '\n') {
+            *cursor_x = line_start;
+            *cursor_y += font->advance_y;
+            continue;
+        }
+        const EpdGlyph* glyph = host_get_glyph(font, cp);
+        if (glyph == NULL && props.fallback_glyph != 0) {
+            glyph = host_get_glyph(font, props.fallback_glyph);
+        }
+        if (glyph == NULL) {
+            continue;
+        }
+        int byte_width = (glyph->width + 1) / 2;
+        uLongf size = byte_width * glyph->height;
+        const uint8_t* bitmap = font->bitmap + glyph->data_offset;
+        uint8_t* buffer = NULL;
+        if (font->compressed && size > 0) {
+            buffer = malloc(size);
+            if (buffer == NULL ||
+                uncompress(buffer, &size, font->bitmap + glyph->data_offset, glyph->compressed_size) != Z_OK) {
+                free(buffer);
+                err = EPD_DRAW_FAILED_ALLOC;
+                *cursor_x += glyph->advance_x;
+                continue;
+            }
+            bitmap = buffer;
+        }
+        for (int y = 0; y < glyph->height; y++) {
+            for (int x = 0; x < glyph->width; x++) {
+                uint8_t value = (bitmap[y * byte_width + x / 2] >> ((x & 1) * 4)) & 0x0F;
+                if (value != 0 || background) {
+                    epd_draw_pixel(*cursor_x + glyph->left + x, *cursor_y - glyph->top + y, color_lut[value] << 4,
+                                   framebuffer);
+                }
+            }
+        }
+        free(buffer);
+        *cursor_x += glyph->advance_x;
+    }
+    return err;
+}
+
+size_t tinfl_decompress_mem_to_mem(void* out_buf, size_t out_buf_len, const void* src_buf, size_t src_buf_len,
+                                   int flags) {
+    (void)flags;
+    uLongf out_len = out_buf_len;
+    if (uncompress(out_buf, &out_len, src_buf, src_buf_len) != Z_OK) {
+        return TINFL_DECOMPRESS_MEM_TO_MEM_FAILED;
+    }
+    return out_len;
+}
+
+// 整个文件读入内存当作已映射的分区
+static esp_partition_t font_partition;
+static uint8_t* font_partition_data = NULL;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    (void)subtype;
+    if (type != ESP_PARTITION_TYPE_DATA || host_font_image == NULL || strcmp(label, "fonts") != 0) {
+        return NULL;
+    }
+    if (font_partition_data == NULL) {
+        FILE* f = fopen(host_font_image, "rb");
+        if (f == NULL) {
+            return NULL;
+        }
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        font_partition_data = malloc(size > 0 ? size : 1);
+        if (fread(font_partition_data, 1, size, f) != (size_t)size) {
+            size = 0;
+        }
+        fclose(f);
+        font_partition = (esp_partition_t){ESP_PARTITION_TYPE_DATA, subtype, 0, (uint32_t)size, "fonts"};
+    }
+    return &font_partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    if (src_offset + size > partition->size) {
+        return ESP_FAIL;
+    }
+    memcpy(dst, font_partition_data + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** out_ptr,
+                             esp_partition_mmap_handle_t* out_handle) {
+    (void)memory;
+    if (offset + size > partition->size) {
+        return ESP_FAIL;
+    }
+    *out_ptr = font_partition_data + offset;
+    *out_handle = 0;
+    return ESP_OK;
+}
+
+enum EpdDrawError epd_write_default(const EpdFont* font, const char* string, int* cursor_x, int* cursor_y,
+                                    uint8_t* framebuffer) {
+    EpdFontProperties props = epd_font_properties_default();
+    return epd_write_string(font, string, cursor_x, cursor_y, framebuffer, &props);
+}
@@ -0,0 +1,420 @@
+#pragma once
+
+// 主机构建用的 ESP-IDF / Bluedroid / epdiy 替身：只声明 main.c 及其模块用到的部分，
+// 实现见 host_stubs.c。BLE 调用同步回调到注册的处理函数，时间由模拟时钟推进。
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+// ---- esp_err / log / heap / timer ----
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+#define ESP_ERR_NVS_NO_FREE_PAGES 0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND 0x1110
+#define ESP_ERROR_CHECK(x) (void)(x)
+
+#define ESP_LOGE(tag, fmt, ...) host_log('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) host_log('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) host_log('I', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) host_log('D', tag, fmt, ##__VA_ARGS__)
+void host_log(char level, const char* tag, const char* fmt, ...);
+
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_8BIT     (1 << 2)
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void heap_caps_free(void* ptr);
+void heap_caps_print_heap_info(uint32_t caps);
+
+#define EXT_RAM_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+
+int64_t esp_timer_get_time(void);
+
+// ---- NVS（内存中的键值表）----
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* len);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t len);
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key);
+esp_err_t nvs_commit(nvs_handle_t handle);
+void nvs_close(nvs_handle_t handle);
+
+// ---- BT controller / Bluedroid ----
+typedef enum { ESP_BT_MODE_IDLE = 0, ESP_BT_MODE_BLE = 1, ESP_BT_MODE_CLASSIC_BT = 2, ESP_BT_MODE_BTDM = 3 } esp_bt_mode_t;
+typedef struct { int unused; } esp_bt_controller_config_t;
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() {0}
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t* cfg);
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+esp_err_t esp_bluedroid_init(void);
+esp_err_t esp_bluedroid_enable(void);
+
+typedef uint8_t esp_bd_addr_t[6];
+typedef uint8_t esp_gatt_if_t;
+#define ESP_GATT_IF_NONE 0xff
+#define ESP_GATT_DEF_BLE_MTU_SIZE 23
+typedef enum { ESP_BT_STATUS_SUCCESS = 0, ESP_BT_STATUS_FAIL } esp_bt_status_t;
+typedef enum {
+    ESP_GATT_OK = 0x0,
+    ESP_GATT_INVALID_OFFSET = 0x07,
+    ESP_GATT_INVALID_ATTR_LEN = 0x0d,
+    ESP_GATT_ERROR = 0x85,
+} esp_gatt_status_t;
+#define ESP_GATT_AUTH_REQ_NONE 0
+
+#define ESP_UUID_LEN_16 2
+typedef struct {
+    uint16_t len;
+    union {
+        uint16_t uuid16;
+        uint32_t uuid32;
+        uint8_t uuid128[16];
+    } uuid;
+} esp_bt_uuid_t;
+typedef struct { esp_bt_uuid_t uuid; uint8_t inst_id; } esp_gatt_id_t;
+typedef struct { esp_gatt_id_t id; bool is_primary; } esp_gatt_srvc_id_t;
+typedef uint16_t esp_gatt_perm_t;
+typedef uint8_t esp_gatt_char_prop_t;
+#define ESP_GATT_PERM_READ  (1 << 0)
+#define ESP_GATT_PERM_WRITE (1 << 4)
+#define ESP_GATT_CHAR_PROP_BIT_READ     (1 << 1)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE_NR (1 << 2)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE    (1 << 3)
+#define ESP_GATT_CHAR_PROP_BIT_NOTIFY   (1 << 4)
+#define ESP_GATT_UUID_CHAR_CLIENT_CONFIG 0x2902
+#define ESP_GATT_PREP_WRITE_CANCEL 0x00
+#define ESP_GATT_PREP_WRITE_EXEC   0x01
+#define ESP_GATT_MAX_ATTR_LEN 600
+
+typedef struct { uint16_t attr_max_len; uint16_t attr_len; uint8_t* attr_value; } esp_attr_value_t;
+typedef struct { uint8_t auto_rsp; } esp_attr_control_t;
+typedef struct {
+    uint8_t value[ESP_GATT_MAX_ATTR_LEN];
+    uint16_t handle;
+    uint16_t offset;
+    uint16_t len;
+    uint8_t auth_req;
+} esp_gatt_value_t;
+typedef union {
+    esp_gatt_value_t attr_value;
+    uint16_t handle;
+} esp_gatt_rsp_t;
+
+typedef enum {
+    ESP_GATTS_REG_EVT = 0,
+    ESP_GATTS_READ_EVT = 1,
+    ESP_GATTS_WRITE_EVT = 2,
+    ESP_GATTS_EXEC_WRITE_EVT = 3,
+    ESP_GATTS_MTU_EVT = 4,
+    ESP_GATTS_CONF_EVT = 5,
+    ESP_GATTS_CREATE_EVT = 7,
+    ESP_GATTS_ADD_CHAR_EVT = 9,
+    ESP_GATTS_ADD_CHAR_DESCR_EVT = 10,
+    ESP_GATTS_START_EVT = 12,
+    ESP_GATTS_CONNECT_EVT = 14,
+    ESP_GATTS_DISCONNECT_EVT = 15,
+} esp_gatts_cb_event_t;
+
+typedef union {
+    struct { esp_gatt_status_t status; uint16_t app_id; } reg;
+    struct { uint16_t conn_id; uint32_t trans_id; esp_bd_addr_t bda; uint16_t handle; uint16_t offset; bool is_long; bool need_rsp; } read;
+    struct { uint16_t conn_id; uint32_t trans_id; esp_bd_addr_t bda; uint16_t handle; uint16_t offset; bool need_rsp; bool is_prep; uint16_t len; uint8_t* value; } write;
+    struct { uint16_t conn_id; uint32_t trans_id; esp_bd_addr_t bda; uint8_t exec_write_flag; } exec_write;
+    struct { uint16_t conn_id; uint16_t mtu; } mtu;
+    struct { esp_gatt_status_t status; uint16_t conn_id; uint16_t handle; uint16_t len; uint8_t* value; } conf;
+    struct { esp_gatt_status_t status; uint16_t service_handle; esp_gatt_srvc_id_t service_id; } create;
+    struct { esp_gatt_status_t status; uint16_t attr_handle; uint16_t service_handle; esp_bt_uuid_t char_uuid; } add_char;
+    struct { esp_gatt_status_t status; uint16_t attr_handle; uint16_t service_handle; esp_bt_uuid_t descr_uuid; } add_char_descr;
+    struct { esp_gatt_status_t status; uint16_t service_handle; } start;
+    struct { uint16_t conn_id; uint8_t link_role; esp_bd_addr_t remote_bda; } connect;
+    struct { uint16_t conn_id; esp_bd_addr_t remote_bda; int reason; } disconnect;
+} esp_ble_gatts_cb_param_t;
+
+typedef void (*esp_gatts_cb_t)(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param);
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback);
+esp_err_t esp_ble_gatts_app_register(uint16_t app_id);
+esp_err_t esp_ble_gatts_create_service(esp_gatt_if_t gatts_if, esp_gatt_srvc_id_t* service_id, uint16_t num_handle);
+esp_err_t esp_ble_gatts_add_char(uint16_t service_handle, esp_bt_uuid_t* char_uuid, esp_gatt_perm_t perm,
+                                 esp_gatt_char_prop_t property, esp_attr_value_t* char_val, esp_attr_control_t* control);
+esp_err_t esp_ble_gatts_add_char_descr(uint16_t service_handle, esp_bt_uuid_t* descr_uuid, esp_gatt_perm_t perm,
+                                       esp_attr_value_t* char_descr_val, esp_attr_control_t* control);
+esp_err_t esp_ble_gatts_start_service(uint16_t service_handle);
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id, uint32_t trans_id,
+                                      esp_gatt_status_t status, esp_gatt_rsp_t* rsp);
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                      uint16_t value_len, uint8_t* value, bool need_confirm);
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu);
+
+// ---- GAP ----
+typedef enum {
+    ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT = 0,
+    ESP_GAP_BLE_ADV_START_COMPLETE_EVT = 6,
+    ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT = 20,
+    ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT = 21,
+    ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT = 51,
+} esp_gap_ble_cb_event_t;
+typedef union {
+    struct { esp_bt_status_t status; } adv_data_cmpl;
+    struct { esp_bt_status_t status; } adv_start_cmpl;
+} esp_ble_gap_cb_param_t;
+typedef struct {
+    bool set_scan_rsp;
+    bool include_name;
+    bool include_txpower;
+    int min_interval;
+    int max_interval;
+    int appearance;
+    uint16_t manufacturer_len;
+    uint8_t* p_manufacturer_data;
+    uint16_t service_data_len;
+    uint8_t* p_service_data;
+    uint16_t service_uuid_len;
+    uint8_t* p_service_uuid;
+    uint8_t flag;
+} esp_ble_adv_data_t;
+#define ESP_BLE_ADV_FLAG_GEN_DISC      (1 << 1)
+#define ESP_BLE_ADV_FLAG_BREDR_NOT_SPT (1 << 2)
+typedef struct {
+    uint16_t adv_int_min;
+    uint16_t adv_int_max;
+    int adv_type;
+    int own_addr_type;
+    int channel_map;
+    int adv_filter_policy;
+} esp_ble_adv_params_t;
+#define ADV_TYPE_IND 0
+#define BLE_ADDR_TYPE_PUBLIC 0
+#define ADV_CHNL_ALL 7
+#define ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY 0
+typedef struct {
+    esp_bd_addr_t bda;
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t timeout;
+} esp_ble_conn_update_params_t;
+#define ESP_BLE_GAP_NO_PREFER_TRANSMIT_PHY (1 << 0)
+#define ESP_BLE_GAP_NO_PREFER_RECEIVE_PHY  (1 << 1)
+#define ESP_BLE_GAP_PHY_2M_PREF_MASK       (1 << 1)
+#define ESP_BLE_GAP_PHY_OPTIONS_NO_PREF    0
+
+typedef void (*esp_gap_ble_cb_t)(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback);
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t* params);
+esp_err_t esp_ble_gap_set_device_name(const char* name);
+esp_err_t esp_ble_gap_config_adv_data(esp_ble_adv_data_t* data);
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t* params);
+esp_err_t esp_ble_gap_set_pkt_data_len(esp_bd_addr_t remote_device, uint16_t tx_data_length);
+esp_err_t esp_ble_gap_set_preferred_phy(esp_bd_addr_t bd_addr, uint8_t all_phys_mask, uint8_t tx_phy_mask,
+                                        uint8_t rx_phy_mask, uint16_t phy_options);
+
+// ---- FreeRTOS（只覆盖用到的部分）----
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+// 一次性的任务（启动时的初始化）在创建时同步运行完；常驻的显示任务不运行，
+// 模拟器在主循环中直接调用它的单步函数
+typedef void (*TaskFunction_t)(void* arg);
+typedef void* TaskHandle_t;
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+
+// 单线程的队列：不阻塞，等待时间被忽略
+typedef struct host_queue* QueueHandle_t;
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+// ---- GPIO ----
+typedef enum { GPIO_MODE_INPUT = 1, GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+esp_err_t gpio_set_direction(int gpio, gpio_mode_t mode);
+esp_err_t gpio_set_level(int gpio, uint32_t level);
+
+// ---- Arduino ----
+void delay(uint32_t ms);
+
+// ---- epdiy ----
+typedef struct { int x; int y; int width; int height; } EpdRect;
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    uint8_t advance_x;
+    int16_t left;
+    int16_t top;
+    uint32_t compressed_size;
+    uint32_t data_offset;
+} EpdGlyph;
+typedef struct { uint32_t first; uint32_t last; uint32_t offset; } EpdUnicodeInterval;
+typedef struct {
+    const uint8_t* bitmap;
+    const EpdGlyph* glyph;
+    const EpdUnicodeInterval* intervals;
+    uint32_t interval_count;
+    bool compressed;
+    uint16_t advance_y;
+    int ascender;
+    int descender;
+} EpdFont;
+enum EpdFontFlags {
+    EPD_DRAW_BACKGROUND = 0x1,
+    EPD_DRAW_ALIGN_LEFT = 0x2,
+    EPD_DRAW_ALIGN_RIGHT = 0x4,
+    EPD_DRAW_ALIGN_CENTER = 0x8,
+};
+typedef struct {
+    uint8_t fg_color : 4;
+    uint8_t bg_color : 4;
+    uint32_t fallback_glyph;
+    enum EpdFontFlags flags;
+} EpdFontProperties;
+enum EpdDrawMode {
+    MODE_INIT = 0x0,
+    MODE_DU = 0x1,
+    MODE_GC16 = 0x2,
+    MODE_GC16_FAST = 0x3,
+    MODE_A2 = 0x4,
+    MODE_GL16 = 0x5,
+};
+enum EpdDrawError { EPD_DRAW_SUCCESS = 0x0, EPD_DRAW_FAILED_ALLOC = 0x1 };
+enum EpdRotation {
+    EPD_ROT_LANDSCAPE = 0,
+    EPD_ROT_PORTRAIT = 1,
+    EPD_ROT_INVERTED_LANDSCAPE = 2,
+    EPD_ROT_INVERTED_PORTRAIT = 3,
+};
+enum EpdInitOptions { EPD_OPTIONS_DEFAULT = 0, EPD_LUT_1K = 1, EPD_LUT_64K = 2 };
+typedef struct { int unused; } EpdWaveform;
+typedef struct { int unused; } EpdBoardDefinition;
+typedef enum { DISPLAY_TYPE_GENERIC = 0 } EpdDisplayType;
+typedef struct {
+    int width;
+    int height;
+    int bus_width;
+    int bus_speed;
+    const EpdWaveform* default_waveform;
+    EpdDisplayType display_type;
+} EpdDisplay_t;
+typedef struct {
+    uint8_t* front_fb;
+    uint8_t* back_fb;
+    uint8_t* difference_fb;
+    bool* dirty_lines;
+    const EpdWaveform* waveform;
+} EpdiyHighlevelState;
+
+extern const EpdWaveform epdiy_ED060SCT;
+extern const EpdBoardDefinition epd_board_v6;
+extern const EpdBoardDefinition epd_board_v7;
+#define EPD_BUILTIN_WAVEFORM (&epdiy_ED060SCT)
+
+void epd_init(const EpdBoardDefinition* board, const EpdDisplay_t* display, enum EpdInitOptions options);
+void epd_set_vcom(uint16_t vcom);
+EpdiyHighlevelState epd_hl_init(const EpdWaveform* waveform);
+uint8_t* epd_hl_get_framebuffer(EpdiyHighlevelState* state);
+void epd_hl_set_all_white(EpdiyHighlevelState* state);
+enum EpdDrawError epd_hl_update_screen(EpdiyHighlevelState* state, enum EpdDrawMode mode, int temperature);
+enum EpdDrawError epd_hl_update_area(EpdiyHighlevelState* state, enum EpdDrawMode mode, int temperature, EpdRect area);
+void epd_set_rotation(enum EpdRotation rotation);
+enum EpdRotation epd_get_rotation(void);
+int epd_rotated_display_width(void);
+int epd_rotated_display_height(void);
+int epd_width(void);
+int epd_height(void);
+int epd_ambient_temperature(void);
+void epd_clear(void);
+void epd_fullclear(EpdiyHighlevelState* state, int temperature);
+void epd_clear_area(EpdRect area);
+void epd_draw_pixel(int x, int y, uint8_t color, uint8_t* framebuffer);
+void epd_fill_rect(EpdRect rect, uint8_t color, uint8_t* framebuffer);
+EpdFontProperties epd_font_properties_default(void);
+enum EpdDrawError epd_write_string(const EpdFont* font, const char* string, int* cursor_x, int* cursor_y,
+                                   uint8_t* framebuffer, const EpdFontProperties* properties);
+enum EpdDrawError epd_write_default(const EpdFont* font, const char* string, int* cursor_x, int* cursor_y,
+                                    uint8_t* framebuffer);
+
+// ---- ROM miniz（用 zlib 实现）----
+#define TINFL_FLAG_PARSE_ZLIB_HEADER 1
+#define TINFL_DECOMPRESS_MEM_TO_MEM_FAILED ((size_t)(-1))
+size_t tinfl_decompress_mem_to_mem(void* out_buf, size_t out_buf_len, const void* src_buf, size_t src_buf_len,
+                                   int flags);
+
+// ---- esp_partition（fonts 分区映射 host_font_image 指定的文件）----
+typedef enum { ESP_PARTITION_TYPE_APP = 0, ESP_PARTITION_TYPE_DATA = 1 } esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+typedef enum { ESP_PARTITION_MMAP_DATA = 0, ESP_PARTITION_MMAP_INST = 1 } esp_partition_mmap_memory_t;
+typedef uint32_t esp_partition_mmap_handle_t;
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size);
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** out_ptr,
+                             esp_partition_mmap_handle_t* out_handle);
+
+// ---- 模拟器接口 ----
+// 模拟时钟（微秒）；delay()/vTaskDelay() 推进它，链路模型也会推进它
+extern int64_t host_time_us;
+void host_advance_us(int64_t us);
+
+// 注册到 Bluedroid 替身的回调
+extern esp_gatts_cb_t host_gatts_cb;
+extern esp_gap_ble_cb_t host_gap_cb;
+
+// 最近一次 esp_ble_gatts_send_response 的内容
+extern esp_gatt_status_t host_rsp_status;
+extern esp_gatt_rsp_t host_rsp;
+extern bool host_rsp_has_value;
+
+// 当前连接协商的 ATT_MTU，由模拟器设置；超出 MTU 的读取应答和通知计入 host_att_oversize
+extern uint16_t host_att_mtu;
+extern int host_att_oversize;
+
+// 状态通知统计
+extern int host_notify_count;
+extern uint32_t host_notify_bytes;
+
+// 面板活动统计
+extern int host_screen_updates;
+extern int host_area_updates;
+extern int64_t host_last_update_us;     // 最近一次刷新开始（图像已写入帧缓冲区）的时间
+extern int64_t host_panel_busy_until_us; // 面板刷新结束的时间
+extern bool host_panel_power;
+extern int host_power_ups;
+extern int host_temperature_reads;
+extern bool host_quiet; // 为 true 时不打印日志
+extern const char* host_font_image; // fonts 分区的内容，NULL 表示没有这个分区
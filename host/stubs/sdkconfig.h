@@ -0,0 +1,5 @@
+#pragma once
+
+// 主机构建的配置：模拟 ESP32-S3 + BLE 5，不启用PSRAM不初始化段
+#define CONFIG_IDF_TARGET_ESP32S3 1
+#define CONFIG_BT_BLE_50_FEATURES_SUPPORTED 1
@@ -0,0 +1,438 @@
+// 主机上的文字绘制基准和金样比对：在一块与面板同尺寸的帧缓冲区中，用固件的字体和绘制路径画一组
+// 有代表性的文字（ASCII、符号、长段落、排版），分别测量字形缓存和排版缓存为空（cold）和已缓存（warm）时
+// 每次绘制的耗时，并与 golden 目录中的 PNG 逐像素比较
+//
+// 构建：
+//   cmake -S host -B build-host && cmake --build build-host
+//
+// 用法：
+//   build-host/text_bench [--iterations N] [--golden DIR] [--update] [--out DIR]
+//   --golden 为金样目录（仓库中是 host/golden），每个用例一个 <名称>.png；--update 用这次的结果重写金样；
+//   --out 把与金样不同的结果写到这个目录，便于对照。有用例不一致时返回1
+//
+// 基准 epdiy 是 stubs 中按 epdiy 做法实现的 epd_write_string（逐字形解压、逐像素绘制），字体是原始的
+// firasans 头文件；其余用例与固件相同：pack12 为控制台的字体包，sdf50 为 RENDER_TEXT 的距离场字体实例
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include "host_stubs.h"
+#include "firasans_12_pack.h"
+#include "firasans_20_sdf.h"
+#include "font_sdf.h"
+#include "glyph_cache.h"
+#include "text_bench.h"
+#include "text_layout.h"
+#include "text_render.h"
+
+#define BENCH_MARGIN     8
+#define BENCH_ITERATIONS 20
+#define BENCH_SDF_SIZE   50 // 与 main.c 的 TEXT_FONT_SIZE 相同
+#define BENCH_BOX_WIDTH  640
+#define BENCH_BOX_HEIGHT 320
+
+typedef enum { BENCH_EPDIY, BENCH_TEXT, BENCH_LAYOUT } bench_renderer_t;
+typedef enum { FONT_EPDIY_12, FONT_EPDIY_20, FONT_PACK_12, FONT_SDF_50 } bench_font_t;
+
+typedef struct {
+    const char* name; // 也是金样的文件名
+    bench_renderer_t renderer;
+    bench_font_t font;
+    int flags;        // 附加到 EpdFontProperties.flags，如 TEXT_DRAW_MONO
+    const char* text;
+} bench_case_t;
+
+static const char ASCII_TEXT[] = "The quick brown fox jumps over the lazy dog 0123456789";
+static const char SYMBOL_TEXT[] = "[RSSI -67 dBm] {ok} 100% #42 @3.3V ~<tile>& \"x\" | a_b/c\\d; (7+8)*9=135!?";
+static const char PARAGRAPH_TEXT[] =
+    "E-paper panels hold an image without power, so a frame that is drawn once can stay on\n"
+    "the screen for days. Text is the most common content: status lines, logs, names and\n"
+    "numbers. Each glyph is an anti-aliased 4bpp bitmap that has to be located, decoded\n"
+    "and composited into the framebuffer before the panel waveform runs, and the console\n"
+    "redraws every line on each new message. Caching decoded glyphs and finished layouts\n"
+    "turns most redraws into plain memory copies, which this benchmark measures directly.";
+static const char LAYOUT_TEXT[] =
+    "Image received: 1448x1072, 4bpp, 776 KB in 9.8 s over BLE. Refreshing the panel now, please wait.";
+
+static const bench_case_t cases[] = {
+    {"ascii_epdiy12", BENCH_EPDIY, FONT_EPDIY_12, 0, ASCII_TEXT},
+    {"ascii_epdiy20", BENCH_EPDIY, FONT_EPDIY_20, 0, ASCII_TEXT},
+    {"ascii_text_epdiy20", BENCH_TEXT, FONT_EPDIY_20, 0, ASCII_TEXT},
+    {"ascii_pack12", BENCH_TEXT, FONT_PACK_12, 0, ASCII_TEXT},
+    {"ascii_sdf50", BENCH_TEXT, FONT_SDF_50, 0, ASCII_TEXT},
+    {"symbols_epdiy12", BENCH_EPDIY, FONT_EPDIY_12, 0, SYMBOL_TEXT},
+    {"symbols_pack12", BENCH_TEXT, FONT_PACK_12, 0, SYMBOL_TEXT},
+    {"symbols_sdf50", BENCH_TEXT, FONT_SDF_50, 0, SYMBOL_TEXT},
+    {"paragraph_epdiy12", BENCH_EPDIY, FONT_EPDIY_12, 0, PARAGRAPH_TEXT},
+    {"paragraph_pack12", BENCH_TEXT, FONT_PACK_12, 0, PARAGRAPH_TEXT},
+    {"paragraph_mono12", BENCH_TEXT, FONT_PACK_12, TEXT_DRAW_MONO, PARAGRAPH_TEXT},
+    {"layout_pack12", BENCH_LAYOUT, FONT_PACK_12, 0, LAYOUT_TEXT},
+    {"layout_sdf50", BENCH_LAYOUT, FONT_SDF_50, 0, LAYOUT_TEXT},
+    {"layout_mono_sdf50", BENCH_LAYOUT, FONT_SDF_50, TEXT_DRAW_MONO, LAYOUT_TEXT},
+};
+#define CASE_COUNT (int)(sizeof(cases) / sizeof(cases[0]))
+
+static uint8_t* framebuffer = NULL;
+
+static const EpdFont* bench_font(bench_font_t font) {
+    switch (font) {
+    case FONT_EPDIY_12:
+        return bench_epdiy_font_12();
+    case FONT_EPDIY_20:
+        return bench_epdiy_font_20();
+    case FONT_PACK_12:
+        return &FiraSans_12;
+    case FONT_SDF_50:
+        return font_sdf_get(&FiraSans_20Sdf, BENCH_SDF_SIZE);
+    }
+    return NULL;
+}
+
+// 用例占用的行数（画布高度），金样图像的尺寸
+static int canvas_height(const bench_case_t* c) {
+    if (c->renderer == BENCH_LAYOUT) {
+        return BENCH_BOX_HEIGHT + 2 * BENCH_MARGIN;
+    }
+    int lines = 1;
+    for (const char* p = c->text; *p; p++) {
+        lines += *p == '\n';
+    }
+    const EpdFont* font = bench_font(c->font);
+    return lines * font->advance_y - font->descender + 2 * BENCH_MARGIN;
+}
+
+static void bench_draw(const bench_case_t* c) {
+    const EpdFont* font = bench_font(c->font);
+    EpdFontProperties props = epd_font_properties_default();
+    props.flags |= c->flags;
+    int x = BENCH_MARGIN;
+    int y = BENCH_MARGIN + font->ascender;
+    switch (c->renderer) {
+    case BENCH_EPDIY:
+        epd_write_string(font, c->text, &x, &y, framebuffer, &props);
+        break;
+    case BENCH_TEXT:
+        text_draw_string(font, c->text, &x, &y, framebuffer, &props);
+        break;
+    case BENCH_LAYOUT: {
+        EpdRect box = {BENCH_MARGIN, BENCH_MARGIN, BENCH_BOX_WIDTH, BENCH_BOX_HEIGHT};
+        const text_layout_t* layout = text_layout_get(font, c->text, box, EPD_DRAW_ALIGN_LEFT, 0);
+        if (layout != NULL) {
+            text_layout_draw(layout, framebuffer, &props);
+        }
+        break;
+    }
+    }
+}
+
+static void clear_canvas(int height) {
+    memset(framebuffer, 0xFF, (size_t)height * epd_width() / 2);
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// 每次绘制耗时的中位数；cold 时每次绘制前清空字形缓存和排版缓存
+static double bench_time(const bench_case_t* c, int height, int iterations, bool cold) {
+    double* samples = malloc(iterations * sizeof(double));
+    if (!cold) {
+        bench_draw(c);
+    }
+    for (int i = 0; i < iterations; i++) {
+        clear_canvas(height);
+        if (cold) {
+            glyph_cache_clear();
+            text_layout_clear();
+        }
+        double start = now_us();
+        bench_draw(c);
+        samples[i] = now_us() - start;
+    }
+    qsort(samples, iterations, sizeof(double), compare_double);
+    double median = samples[iterations / 2];
+    free(samples);
+    return median;
+}
+
+// 画布转换成8位灰度
+static uint8_t* canvas_pixels(int height) {
+    int width = epd_width();
+    uint8_t* pixels = malloc((size_t)width * height);
+    for (int i = 0; i < width * height; i++) {
+        pixels[i] = ((framebuffer[i / 2] >> ((i & 1) * 4)) & 0x0F) * 17;
+    }
+    return pixels;
+}
+
+// ---- 8位灰度 PNG ----
+static void put_be32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static uint32_t get_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void png_chunk(FILE* f, const char* type, const uint8_t* data, uint32_t len) {
+    uint8_t header[8];
+    put_be32(header, len);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, 8, f);
+    fwrite(data, 1, len, f);
+    uint32_t crc = crc32(crc32(0, (const Bytef*)type, 4), data, len);
+    uint8_t trailer[4];
+    put_be32(trailer, crc);
+    fwrite(trailer, 1, 4, f);
+}
+
+static bool png_write(const char* path, const uint8_t* pixels, int width, int height) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    // 每行前加过滤类型0
+    uLong raw_len = (uLong)(width + 1) * height;
+    uint8_t* raw = malloc(raw_len);
+    for (int y = 0; y < height; y++) {
+        raw[y * (width + 1)] = 0;
+        memcpy(raw + y * (width + 1) + 1, pixels + (size_t)y * width, width);
+    }
+    uLongf packed_len = compressBound(raw_len);
+    uint8_t* packed = malloc(packed_len);
+    compress2(packed, &packed_len, raw, raw_len, Z_BEST_COMPRESSION);
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t ihdr[13] = {0};
+    put_be32(ihdr, width);
+    put_be32(ihdr + 4, height);
+    ihdr[8] = 8; // 位深度；颜色类型、压缩、过滤、隔行都是0
+    fwrite(signature, 1, sizeof(signature), f);
+    png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    png_chunk(f, "IDAT", packed, packed_len);
+    png_chunk(f, "IEND", NULL, 0);
+    fclose(f);
+    free(raw);
+    free(packed);
+    return true;
+}
+
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+}
+
+// 只支持不隔行的8位灰度图，返回 malloc 的像素，失败时返回 NULL
+static uint8_t* png_read(const char* path, int* width_out, int* height_out) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* file = malloc(size > 0 ? size : 1);
+    bool ok = size > 8 && fread(file, 1, size, f) == (size_t)size;
+    fclose(f);
+
+    int width = 0;
+    int height = 0;
+    uint8_t* idat = NULL;
+    size_t idat_len = 0;
+    for (long pos = 8; ok && pos + 12 <= size;) {
+        uint32_t len = get_be32(file + pos);
+        const uint8_t* type = file + pos + 4;
+        const uint8_t* data = file + pos + 8;
+        if (pos + 12 + (long)len > size) {
+            ok = false;
+        } else if (memcmp(type, "IHDR", 4) == 0) {
+            width = get_be32(data);
+            height = get_be32(data + 4);
+            ok = len == 13 && data[8] == 8 && data[9] == 0 && data[12] == 0 && width > 0 && height > 0;
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            idat = realloc(idat, idat_len + len);
+            memcpy(idat + idat_len, data, len);
+            idat_len += len;
+        }
+        pos += 12 + len;
+    }
+
+    uint8_t* pixels = NULL;
+    if (ok && idat != NULL) {
+        uLongf raw_len = (uLongf)(width + 1) * height;
+        uint8_t* raw = malloc(raw_len);
+        if (uncompress(raw, &raw_len, idat, idat_len) == Z_OK && raw_len == (uLongf)(width + 1) * height) {
+            pixels = malloc((size_t)width * height);
+            for (int y = 0; y < height && pixels != NULL; y++) {
+                const uint8_t* in = raw + y * (width + 1) + 1;
+                uint8_t* out = pixels + (size_t)y * width;
+                const uint8_t* up = y > 0 ? out - width : NULL;
+                uint8_t filter = in[-1];
+                for (int x = 0; x < width; x++) {
+                    int a = x > 0 ? out[x - 1] : 0;
+                    int b = up != NULL ? up[x] : 0;
+                    int c = x > 0 && up != NULL ? up[x - 1] : 0;
+                    int predictor = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) / 2
+                                                  : filter == 4   ? paeth(a, b, c)
+                                                                  : 0;
+                    if (filter > 4) {
+                        free(pixels);
+                        pixels = NULL;
+                        break;
+                    }
+                    out[x] = in[x] + predictor;
+                }
+            }
+        }
+        free(raw);
+    }
+    free(idat);
+    free(file);
+    if (pixels != NULL) {
+        *width_out = width;
+        *height_out = height;
+    }
+    return pixels;
+}
+
+// 与金样比较，返回 true 表示一致（或已更新金样）
+static bool bench_check_golden(const bench_case_t* c, const uint8_t* pixels, int height, const char* golden_dir,
+                               bool update, const char* out_dir) {
+    int width = epd_width();
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.png", golden_dir, c->name);
+    if (update) {
+        return png_write(path, pixels, width, height);
+    }
+    int golden_width;
+    int golden_height;
+    uint8_t* golden = png_read(path, &golden_width, &golden_height);
+    bool same = false;
+    if (golden == NULL) {
+        printf("  %s: cannot read golden image\n", path);
+    } else if (golden_width != width || golden_height != height) {
+        printf("  %s: golden is %dx%d, rendered %dx%d\n", c->name, golden_width, golden_height, width, height);
+    } else {
+        int differing = 0;
+        int max_diff = 0;
+        for (int i = 0; i < width * height; i++) {
+            int diff = abs(golden[i] - pixels[i]);
+            differing += diff != 0;
+            max_diff = diff > max_diff ? diff : max_diff;
+        }
+        same = differing == 0;
+        if (!same) {
+            printf("  %s: %d pixels differ from golden (max %d levels)\n", c->name, differing, max_diff / 17);
+        }
+    }
+    free(golden);
+    if (!same && out_dir != NULL) {
+        snprintf(path, sizeof(path), "%s/%s.png", out_dir, c->name);
+        png_write(path, pixels, width, height);
+    }
+    return same;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--iterations N] [--golden DIR] [--update] [--out DIR]\n", prog);
+}
+
+int main(int argc, char** argv) {
+    int iterations = BENCH_ITERATIONS;
+    const char* golden_dir = NULL;
+    const char* out_dir = NULL;
+    bool update = false;
+    host_quiet = true;
+
+    for (int i = 1; i < argc; i++) {
+        const char* opt = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(opt, "--update") == 0) {
+            update = true;
+            continue;
+        }
+        if (val == NULL) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (strcmp(opt, "--iterations") == 0) {
+            iterations = atoi(val);
+        } else if (strcmp(opt, "--golden") == 0) {
+            golden_dir = val;
+        } else if (strcmp(opt, "--out") == 0) {
+            out_dir = val;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (iterations < 1 || (update && golden_dir == NULL)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    framebuffer = malloc((size_t)epd_width() * epd_height() / 2);
+    glyph_cache_init();
+    if (bench_font(FONT_SDF_50) == NULL) {
+        fprintf(stderr, "cannot create SDF font\n");
+        return 1;
+    }
+
+    printf("%-20s %10s %10s %8s  %s\n", "case", "cold us", "warm us", "glyphs", "check");
+    int failures = 0;
+    for (int i = 0; i < CASE_COUNT; i++) {
+        const bench_case_t* c = &cases[i];
+        int height = canvas_height(c);
+        double cold = bench_time(c, height, iterations, true);
+        double warm = bench_time(c, height, iterations, false);
+
+        // 缓存不能改变结果：冷启动画一次、缓存后再画一次，两次必须相同
+        glyph_cache_clear();
+        text_layout_clear();
+        clear_canvas(height);
+        bench_draw(c);
+        uint8_t* pixels = canvas_pixels(height);
+        clear_canvas(height);
+        bench_draw(c);
+        uint8_t* again = canvas_pixels(height);
+        bool stable = memcmp(pixels, again, (size_t)epd_width() * height) == 0;
+        free(again);
+
+        int glyphs = 0;
+        for (const char* p = c->text; *p; p++) {
+            glyphs += *p != '\n' && ((uint8_t)*p & 0xC0) != 0x80;
+        }
+        bool same = golden_dir == NULL || bench_check_golden(c, pixels, height, golden_dir, update, out_dir);
+        const char* check = !stable ? "UNSTABLE" : golden_dir == NULL ? "-" : update ? "updated" : same ? "ok" : "DIFF";
+        printf("%-20s %10.1f %10.1f %8d  %s\n", c->name, cold, warm, glyphs, check);
+        failures += !stable || !same;
+        free(pixels);
+    }
+
+    glyph_cache_stats_t stats;
+    glyph_cache_get_stats(&stats);
+    printf("glyph cache   %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " evictions, %" PRIu32 " errors\n",
+           stats.hits, stats.misses, stats.evictions, stats.errors);
+    free(framebuffer);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <epdiy.h>
+
+// 编译进 text_bench 的原始 epdiy 字体（zlib 压缩，未裁剪），见 text_bench_fonts.c
+const EpdFont* bench_epdiy_font_12(void);
+const EpdFont* bench_epdiy_font_20(void);
@@ -0,0 +1,22 @@
+// 原始的 epdiy 字体，作为 text_bench 的基准。符号与生成的字体包同名，在这里改名后引入
+#include "text_bench.h"
+
+#define FiraSans_12Bitmaps   EpdiyFiraSans_12Bitmaps
+#define FiraSans_12Glyphs    EpdiyFiraSans_12Glyphs
+#define FiraSans_12Intervals EpdiyFiraSans_12Intervals
+#define FiraSans_12          EpdiyFiraSans_12
+#include "firasans_12.h"
+
+#define FiraSans_20Bitmaps   EpdiyFiraSans_20Bitmaps
+#define FiraSans_20Glyphs    EpdiyFiraSans_20Glyphs
+#define FiraSans_20Intervals EpdiyFiraSans_20Intervals
+#define FiraSans_20          EpdiyFiraSans_20
+#include "firasans_20.h"
+
+const EpdFont* bench_epdiy_font_12(void) {
+    return &EpdiyFiraSans_12;
+}
+
+const EpdFont* bench_epdiy_font_20(void) {
+    return &EpdiyFiraSans_20;
+}
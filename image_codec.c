@@ -0,0 +1,181 @@
+#include "image_codec.h"
+
+#include <string.h>
+
+// RLE 记录格式：一个标记字节 (L << 4) | V，V 为像素值
+//   L < 15  : 游程长度 L + 1
+//   L == 15 : 后跟 LEB128 变长整数 n，游程长度 16 + n
+// 像素按半字节顺序排列，每字节高4位在前（与发送端打包顺序一致）
+enum {
+    RLE_TOKEN = 0,
+    RLE_VARINT,
+};
+
+// LZ 记录格式（按位，高位在前）：
+//   1 + 8位字面量
+//   0 + 窗口索引(距离-1) + 长度(长度-1)
+enum {
+    LZ_TAG = 0,
+    LZ_LITERAL,
+    LZ_INDEX,
+    LZ_COUNT,
+};
+
+void image_decoder_init(image_decoder_t* dec, uint8_t encoding, uint8_t* out, uint32_t out_len) {
+    memset(dec, 0, sizeof(*dec));
+    dec->encoding = encoding;
+    dec->out = out;
+    dec->out_len = out_len;
+}
+
+uint32_t image_decoder_output_size(const image_decoder_t* dec) {
+    if (dec->encoding == IMAGE_ENCODING_RLE) {
+        return (dec->out_pos + 1) / 2;
+    }
+    return dec->out_pos;
+}
+
+static image_decode_status_t decode_raw(image_decoder_t* dec, const uint8_t* in, size_t len) {
+    uint32_t room = dec->out_len - dec->out_pos;
+    uint32_t n = len < room ? len : room;
+    memcpy(dec->out + dec->out_pos, in, n);
+    dec->out_pos += n;
+    return dec->out_pos == dec->out_len ? IMAGE_DECODE_DONE : IMAGE_DECODE_MORE;
+}
+
+// 写入一段相同像素值的游程，字节对齐部分直接 memset
+static bool rle_emit(image_decoder_t* dec, uint8_t value, uint32_t run) {
+    uint32_t nibbles = dec->out_len * 2;
+    if (run > nibbles - dec->out_pos) {
+        return false;
+    }
+    uint8_t* out = dec->out;
+    uint32_t pos = dec->out_pos;
+    if ((pos & 1) && run > 0) {
+        out[pos / 2] |= value;
+        pos++;
+        run--;
+    }
+    uint32_t bytes = run / 2;
+    if (bytes > 0) {
+        memset(out + pos / 2, (value << 4) | value, bytes);
+        pos += bytes * 2;
+    }
+    if (run & 1) {
+        out[pos / 2] = value << 4;
+        pos++;
+    }
+    dec->out_pos = pos;
+    return true;
+}
+
+static image_decode_status_t decode_rle(image_decoder_t* dec, const uint8_t* in, size_t len) {
+    const uint8_t* end = in + len;
+    while (in < end && dec->out_pos < dec->out_len * 2) {
+        uint8_t b = *in++;
+        if (dec->state == RLE_TOKEN) {
+            uint8_t run = b >> 4;
+            if (run < 15) {
+                if (!rle_emit(dec, b & 0x0F, run + 1)) {
+                    return IMAGE_DECODE_ERROR;
+                }
+            } else {
+                dec->arg = b & 0x0F;
+                dec->bit_buf = 0;
+                dec->shift = 0;
+                dec->state = RLE_VARINT;
+            }
+        } else {
+            if (dec->shift > 21) {
+                return IMAGE_DECODE_ERROR;
+            }
+            dec->bit_buf |= (uint32_t)(b & 0x7F) << dec->shift;
+            dec->shift += 7;
+            if ((b & 0x80) == 0) {
+                if (!rle_emit(dec, dec->arg, 16 + dec->bit_buf)) {
+                    return IMAGE_DECODE_ERROR;
+                }
+                dec->state = RLE_TOKEN;
+            }
+        }
+    }
+    return dec->out_pos == dec->out_len * 2 ? IMAGE_DECODE_DONE : IMAGE_DECODE_MORE;
+}
+
+// 从位缓冲区取 n 位；输入不足时返回 false，已读入的位保留到下一次调用
+static bool take_bits(image_decoder_t* dec, const uint8_t** in, const uint8_t* end, uint8_t n, uint32_t* value) {
+    while (dec->bit_count < n) {
+        if (*in == end) {
+            return false;
+        }
+        dec->bit_buf = (dec->bit_buf << 8) | *(*in)++;
+        dec->bit_count += 8;
+    }
+    dec->bit_count -= n;
+    *value = (dec->bit_buf >> dec->bit_count) & ((1u << n) - 1);
+    return true;
+}
+
+static image_decode_status_t decode_lz(image_decoder_t* dec, const uint8_t* in, size_t len) {
+    const uint8_t* end = in + len;
+    uint32_t v;
+    while (dec->out_pos < dec->out_len) {
+        switch (dec->state) {
+        case LZ_TAG:
+            if (!take_bits(dec, &in, end, 1, &v)) {
+                return IMAGE_DECODE_MORE;
+            }
+            dec->state = v ? LZ_LITERAL : LZ_INDEX;
+            break;
+        case LZ_LITERAL:
+            if (!take_bits(dec, &in, end, 8, &v)) {
+                return IMAGE_DECODE_MORE;
+            }
+            dec->out[dec->out_pos++] = v;
+            dec->state = LZ_TAG;
+            break;
+        case LZ_INDEX:
+            if (!take_bits(dec, &in, end, IMAGE_LZ_WINDOW_BITS, &v)) {
+                return IMAGE_DECODE_MORE;
+            }
+            dec->arg = v + 1;
+            dec->state = LZ_COUNT;
+            break;
+        case LZ_COUNT: {
+            if (!take_bits(dec, &in, end, IMAGE_LZ_LOOKAHEAD_BITS, &v)) {
+                return IMAGE_DECODE_MORE;
+            }
+            uint32_t count = v + 1;
+            uint32_t dist = dec->arg;
+            if (dist > dec->out_pos || count > dec->out_len - dec->out_pos) {
+                return IMAGE_DECODE_ERROR;
+            }
+            // 回溯区域可能与输出重叠（长游程），必须逐字节复制
+            uint8_t* dst = dec->out + dec->out_pos;
+            const uint8_t* src = dst - dist;
+            for (uint32_t i = 0; i < count; i++) {
+                dst[i] = src[i];
+            }
+            dec->out_pos += count;
+            dec->state = LZ_TAG;
+            break;
+        }
+        default:
+            return IMAGE_DECODE_ERROR;
+        }
+    }
+    return IMAGE_DECODE_DONE;
+}
+
+image_decode_status_t image_decoder_feed(image_decoder_t* dec, const uint8_t* in, size_t len) {
+    switch (dec->encoding) {
+    case IMAGE_ENCODING_RAW:
+        return decode_raw(dec, in, len);
+    case IMAGE_ENCODING_RLE:
+        return decode_rle(dec, in, len);
+    case IMAGE_ENCODING_LZ:
+        return decode_lz(dec, in, len);
+    default:
+        return IMAGE_DECODE_ERROR;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 传输编码方式（需与 image_converter_sender.py 中的定义保持一致）
+#define IMAGE_ENCODING_RAW 0 // 原始4位灰度数据
+#define IMAGE_ENCODING_RLE 1 // 半字节游程编码
+#define IMAGE_ENCODING_LZ  2 // heatshrink风格的LZSS，固定小窗口
+
+// LZ 参数：回溯窗口 2^11 字节，长度字段 8 位（单次匹配最长256字节）
+#define IMAGE_LZ_WINDOW_BITS    11
+#define IMAGE_LZ_LOOKAHEAD_BITS 8
+
+typedef enum {
+    IMAGE_DECODE_MORE = 0, // 需要更多输入
+    IMAGE_DECODE_DONE,     // 输出缓冲区已填满
+    IMAGE_DECODE_ERROR,    // 数据损坏或越界
+} image_decode_status_t;
+
+// 流式解码器状态，数据分包到达时可以逐包调用 image_decoder_feed()
+typedef struct {
+    uint8_t encoding;
+    uint8_t state;
+    uint8_t bit_count;
+    uint8_t shift;
+    uint32_t bit_buf;
+    uint32_t arg;      // 当前记录的中间值（游程像素值或回溯索引）
+    uint8_t* out;
+    uint32_t out_len;  // 期望输出字节数
+    uint32_t out_pos;  // 已输出的量：RLE 以半字节计，其余以字节计
+} image_decoder_t;
+
+void image_decoder_init(image_decoder_t* dec, uint8_t encoding, uint8_t* out, uint32_t out_len);
+
+// 输入一段压缩数据；输出填满后多余的输入会被忽略
+image_decode_status_t image_decoder_feed(image_decoder_t* dec, const uint8_t* in, size_t len);
+
+// 已解码的字节数
+uint32_t image_decoder_output_size(const image_decoder_t* dec);
@@ -10,11 +10,63 @@ from bleak import BleakClient, BleakScanner
 # 蓝牙服务和特征UUID
 IMAGE_SERVICE_UUID = "00FF"
 IMAGE_CHAR_UUID = "FF01"
+TILE_HASH_CHAR_UUID = "FF02"
+STATUS_CHAR_UUID = "FF03"
+BULK_CHAR_UUID = "FF04"
 
 # 目标图像尺寸
 TARGET_WIDTH = 300
 TARGET_HEIGHT = 396
 
+# 设备端接收缓冲区大小（与 main.c 中 IMAGE_BUFFER_SIZE 一致）
+IMAGE_BUFFER_SIZE = 300 * 396
+
+# 传输协议操作码（与 main.c 保持一致）
+IMAGE_OP_BEGIN = 0x01
+IMAGE_OP_DATA = 0x02
+IMAGE_OP_DELTA_BEGIN = 0x03
+IMAGE_OP_QUERY = 0x04
+IMAGE_OP_TEXT = 0x05
+TEXT_MAX_BYTES = 127  # 设备上 RENDER_TEXT_MAX - 1
+
+# 断点续传参数（与 rx_session.h / main.c 保持一致）
+RX_BLOCK_SIZE = 32
+TRANSFER_STATUS_HEADER = 20
+TRANSFER_STATUS_FORMAT = '<IIIBBHBBH'
+TRANSFER_STATUS_RANGES_MAX = 60
+TRANSFER_STATE_COMPLETE = 2
+TRANSFER_STAGE_DISPLAYED = 4
+TRANSFER_FLAG_REFRESHING = 0x01
+TRANSFER_STAGES = ['空闲', '接收中', '已校验', '显示中', '已显示']
+TRANSFER_ERRORS = ['', '头信息错误', '数据过大', '内存不足', '增量基准不一致', '解码失败',
+                   '哈希不一致', '偏移越界', '未知操作码', '设备忙']
+TRANSFER_ERROR_BUSY = 9
+DISPLAY_TIMEOUT = 15  # 等待设备完成刷新的时间（秒）
+BUSY_RETRY_INTERVAL = 0.5  # 设备两块接收缓冲区都在等待显示时的重试间隔（秒）
+BUSY_RETRY_MAX = 60
+MAX_RESEND_ROUNDS = 5
+
+# 低MTU时通过控制特征使用长写入（prepare/execute），单个属性值最长512字节
+LONG_WRITE_MAX = 512
+LONG_WRITE_MTU = 185
+
+# 分块参数（与 tile_hash.h 保持一致）
+TILE_SIZE = 32
+TILE_BYTES = TILE_SIZE * TILE_SIZE // 2
+TILE_HASH_PAGE_HEADER = 12
+
+# 传输编码（与 image_codec.h 保持一致）
+ENCODING_RAW = 0
+ENCODING_RLE = 1
+ENCODING_LZ = 2
+ENCODINGS = {'raw': ENCODING_RAW, 'rle': ENCODING_RLE, 'lz': ENCODING_LZ}
+
+# LZ 参数：窗口 2^11 字节，长度字段 8 位
+LZ_WINDOW_BITS = 11
+LZ_LOOKAHEAD_BITS = 8
+LZ_MIN_MATCH = 3
+LZ_MAX_CHAIN = 32
+
 def convert_to_4bit_grayscale(image_path, target_width=TARGET_WIDTH, target_height=TARGET_HEIGHT):
     """将图片转换为4位灰度图像格式"""
     # 读取图片
@@ -54,6 +106,285 @@ def convert_to_4bit_grayscale(image_path, target_width=TARGET_WIDTH, target_heig
     # 将二维数组展平为一维数组
     return result.flatten(), target_width, target_height
 
+def encode_rle(data):
+    """半字节游程编码：标记字节 (L << 4) | V，L == 15 时后跟 LEB128 扩展长度"""
+    out = bytearray()
+    nibbles = []
+    for b in data:
+        nibbles.append(b >> 4)
+        nibbles.append(b & 0x0F)
+
+    i = 0
+    total = len(nibbles)
+    while i < total:
+        value = nibbles[i]
+        j = i + 1
+        while j < total and nibbles[j] == value:
+            j += 1
+        run = j - i
+        if run < 16:
+            out.append(((run - 1) << 4) | value)
+        else:
+            out.append(0xF0 | value)
+            n = run - 16
+            while True:
+                byte = n & 0x7F
+                n >>= 7
+                if n:
+                    out.append(byte | 0x80)
+                else:
+                    out.append(byte)
+                    break
+        i = j
+    return bytes(out)
+
+
+class _BitWriter:
+    """高位在前的位写入器，末尾不足一字节时补0"""
+
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.bits = 0
+
+    def write(self, value, count):
+        self.acc = (self.acc << count) | value
+        self.bits += count
+        while self.bits >= 8:
+            self.bits -= 8
+            self.out.append((self.acc >> self.bits) & 0xFF)
+        self.acc &= (1 << self.bits) - 1
+
+    def finish(self):
+        if self.bits:
+            self.out.append((self.acc << (8 - self.bits)) & 0xFF)
+            self.acc = 0
+            self.bits = 0
+        return bytes(self.out)
+
+
+def encode_lz(data):
+    """heatshrink风格的LZSS编码：1+字面量 或 0+距离+长度，固定小窗口"""
+    window = 1 << LZ_WINDOW_BITS
+    max_len = 1 << LZ_LOOKAHEAD_BITS
+    writer = _BitWriter()
+    chains = {}
+    total = len(data)
+
+    def insert(pos):
+        if pos + LZ_MIN_MATCH <= total:
+            chains.setdefault(data[pos:pos + LZ_MIN_MATCH], []).append(pos)
+
+    i = 0
+    while i < total:
+        best_len = 0
+        best_dist = 0
+        candidates = chains.get(data[i:i + LZ_MIN_MATCH], [])
+        limit = min(max_len, total - i)
+        for pos in reversed(candidates[-LZ_MAX_CHAIN:]):
+            dist = i - pos
+            if dist > window:
+                break
+            length = 0
+            while length < limit and data[pos + length] == data[i + length]:
+                length += 1
+            if length > best_len:
+                best_len = length
+                best_dist = dist
+                if length == limit:
+                    break
+
+        if best_len >= LZ_MIN_MATCH:
+            writer.write(0, 1)
+            writer.write(best_dist - 1, LZ_WINDOW_BITS)
+            writer.write(best_len - 1, LZ_LOOKAHEAD_BITS)
+            for k in range(best_len):
+                insert(i + k)
+            i += best_len
+        else:
+            writer.write(1, 1)
+            writer.write(data[i], 8)
+            insert(i)
+            i += 1
+    return writer.finish()
+
+
+def encode_payload(data, encoding='auto'):
+    """按指定编码压缩图像数据；auto 时选择最小的结果"""
+    data = bytes(data)
+    encoders = {
+        'raw': lambda d: d,
+        'rle': encode_rle,
+        'lz': encode_lz,
+    }
+    if encoding != 'auto':
+        return ENCODINGS[encoding], encoders[encoding](data)
+
+    best = None
+    for name, encoder in encoders.items():
+        payload = encoder(data)
+        if best is None or len(payload) < len(best[1]):
+            best = (ENCODINGS[name], payload)
+    return best
+
+def payload_hash(data):
+    """压缩数据的 FNV-1a 哈希，作为设备端的会话标识"""
+    h = 0x811C9DC5
+    for b in data:
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def tile_hashes(image_bytes, width, height):
+    """按 TILE_SIZE 分块计算 FNV-1a 哈希，行优先排列（与设备端 tile_hash.c 一致）"""
+    stride = width // 2
+    cols = (width + TILE_SIZE - 1) // TILE_SIZE
+    rows = (height + TILE_SIZE - 1) // TILE_SIZE
+    hashes = []
+    for row in range(rows):
+        y0 = row * TILE_SIZE
+        lines = min(TILE_SIZE, height - y0)
+        for col in range(cols):
+            x0 = col * TILE_SIZE
+            row_bytes = (min(TILE_SIZE, width - x0) + 1) // 2
+            h = 0x811C9DC5
+            for y in range(y0, y0 + lines):
+                start = y * stride + x0 // 2
+                for b in image_bytes[start:start + row_bytes]:
+                    h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+            hashes.append(h)
+    return hashes
+
+
+def build_delta_records(image_bytes, width, height, changed):
+    """为变化的分块生成增量记录：[u16 列][u16 行][TILE_BYTES 字节]，边缘补白"""
+    stride = width // 2
+    cols = (width + TILE_SIZE - 1) // TILE_SIZE
+    out = bytearray()
+    for index in changed:
+        col, row = index % cols, index // cols
+        x0, y0 = col * TILE_SIZE, row * TILE_SIZE
+        row_bytes = (min(TILE_SIZE, width - x0) + 1) // 2
+        out += struct.pack('<HH', col, row)
+        for y in range(y0, y0 + TILE_SIZE):
+            line = bytearray([0xFF]) * (TILE_SIZE // 2)
+            if y < height:
+                start = y * stride + x0 // 2
+                line[:row_bytes] = image_bytes[start:start + row_bytes]
+            out += line
+    return bytes(out)
+
+
+async def read_tile_hashes(client, hash_char):
+    """分页读取设备当前图像的分块哈希，返回 (宽, 高, 哈希列表)"""
+    hashes = []
+    width = height = 0
+    while True:
+        await client.write_gatt_char(hash_char, struct.pack('<H', len(hashes)), response=True)
+        page = await client.read_gatt_char(hash_char)
+        first, count, total, tile_size, width, height = struct.unpack_from('<6H', page)
+        if total == 0 or tile_size != TILE_SIZE:
+            return 0, 0, []
+        hashes += struct.unpack_from(f'<{count}I', page, TILE_HASH_PAGE_HEADER)
+        if count == 0 or len(hashes) >= total:
+            return width, height, hashes
+
+
+class TraceRecorder:
+    """记录发送过程中的 GATT 操作，供 host/gatts_sim 回放。
+    每行：<毫秒> connect <mtu> | disconnect | w/n <UUID> <十六进制数据> | r <UUID>"""
+    def __init__(self, path):
+        self.file = open(path, 'w')
+        self.start = time.monotonic()
+
+    def log(self, *fields):
+        elapsed = (time.monotonic() - self.start) * 1000
+        self.file.write(f"{elapsed:.1f} " + ' '.join(fields) + '\n')
+        self.file.flush()
+
+
+def short_uuid(char):
+    """特征的16位UUID，例如 0000ff01-0000-1000-8000-00805f9b34fb -> ff01"""
+    return char.uuid[4:8]
+
+
+class TracingClient:
+    """包装 BleakClient，把读写操作写入 TraceRecorder"""
+    def __init__(self, client, trace):
+        self._client = client
+        self._trace = trace
+
+    def __getattr__(self, name):
+        return getattr(self._client, name)
+
+    async def write_gatt_char(self, char, data, response=False):
+        self._trace.log('w' if response else 'n', short_uuid(char), bytes(data).hex())
+        return await self._client.write_gatt_char(char, data, response=response)
+
+    async def read_gatt_char(self, char):
+        self._trace.log('r', short_uuid(char))
+        return await self._client.read_gatt_char(char)
+
+    async def start_notify(self, char, callback):
+        # 订阅在设备端是对客户端配置描述符（2902）的写入
+        self._trace.log('w', '2902', '0100')
+        return await self._client.start_notify(char, callback)
+
+
+def parse_transfer_status(page):
+    """解析状态特征的读取结果或通知"""
+    (content_hash, size, received, state, stage, count,
+     error, flags, _) = struct.unpack_from(TRANSFER_STATUS_FORMAT, page)
+    count = min(count, (len(page) - TRANSFER_STATUS_HEADER) // 8)
+    ranges = [struct.unpack_from('<II', page, TRANSFER_STATUS_HEADER + i * 8) for i in range(count)]
+    return {'hash': content_hash, 'size': size, 'received': received, 'state': state,
+            'stage': stage, 'error': error, 'refreshing': bool(flags & TRANSFER_FLAG_REFRESHING),
+            'ranges': ranges}
+
+
+class TransferProgress:
+    """在终端的同一行显示本地发送进度和设备通知的接收状态"""
+    def __init__(self, content_hash):
+        self.content_hash = content_hash
+        self.sent = 0
+        self.total = 0
+        self.status = None
+        self.displayed = asyncio.Event()
+
+    def on_sent(self, sent, total):
+        self.sent, self.total = sent, total
+        self.render()
+
+    def on_status(self, _char, data):
+        status = parse_transfer_status(bytes(data))
+        self.status = status
+        if status['stage'] == TRANSFER_STAGE_DISPLAYED and status['hash'] == self.content_hash:
+            self.displayed.set()
+        self.render()
+
+    def render(self):
+        line = f"发送 {self.sent}/{self.total} 字节"
+        status = self.status
+        if status:
+            if status['size']:
+                done = status['received'] / status['size']
+                bar = '#' * int(done * 20)
+                line += f" | 设备 [{bar:<20}] {done:4.0%}"
+            stage = status['stage']
+            line += f" {TRANSFER_STAGES[stage] if stage < len(TRANSFER_STAGES) else stage}"
+            if status['ranges']:
+                line += f" 缺失{len(status['ranges'])}段"
+            if status['refreshing']:
+                line += " 刷新中"
+            if status['error']:
+                error = status['error']
+                line += f" 错误: {TRANSFER_ERRORS[error] if error < len(TRANSFER_ERRORS) else error}"
+        print('\r' + line + '\033[K', end='', flush=True)
+
+    def finish(self):
+        print()
+
+
 async def find_device(device_name):
     """查找指定名称的蓝牙设备"""
     print(f"正在搜索设备: {device_name}...")
@@ -64,77 +395,243 @@ async def find_device(device_name):
             return device.address
     return None
 
-async def send_image(device_address, image_data, width, height):
-    """通过蓝牙发送图像数据到ESP32"""
-    try:
-        async with BleakClient(device_address) as client:
-            print(f"已连接到: {device_address}")
-            
-            # 检查服务和特征是否存在
-            services = await client.get_services()
-            target_service = None
-            target_char = None
-            
-            for service in services:
-                if IMAGE_SERVICE_UUID.lower() in service.uuid.lower():
-                    target_service = service
-                    for char in service.characteristics:
-                        if IMAGE_CHAR_UUID.lower() in char.uuid.lower():
-                            target_char = char
-                            break
-                    break
-            
-            if not target_char:
-                print("未找到目标特征，请检查UUID是否正确")
-                return False
-            
-            # 准备数据包：前8个字节是宽度和高度，然后是图像数据
-            header = struct.pack('<II', width, height)  # 小端序，两个无符号整数
-            
-            # 将NumPy数组转换为bytes
-            image_bytes = image_data.tobytes()
-            
-            # 发送第一个数据包（包含头信息）
-            first_packet = header + image_bytes[:492]  # 500字节MTU - 8字节头信息
-            # await client.write_gatt_char(target_char, first_packet, response=True)  # 添加response=True
-            await asyncio.sleep(5)
-            print(f"已发送头信息和第一部分数据: {len(first_packet)} 字节")
-            
-            # 发送剩余数据
-            chunk_size = 500  # BLE MTU大小
-            remaining_data = image_bytes[492:]
-            total_chunks = (len(remaining_data) + chunk_size - 1) // chunk_size
-            
-            for i in range(0, len(remaining_data), chunk_size):
-                chunk = remaining_data[i:i+chunk_size]
-                # await client.write_gatt_char(target_char, chunk)
-                chunk_num = i // chunk_size + 1
-                print(f"已发送数据块 {chunk_num}/{total_chunks}: {len(chunk)} 字节")
-                # 添加短暂延迟，避免发送过快导致数据丢失
-                await asyncio.sleep(3)
-            
-            print(f"图像数据发送完成，总大小: {len(image_bytes) + len(header)} 字节")
+def find_characteristics(services):
+    """在图像服务中查找各个特征，返回 {UUID: 特征}"""
+    wanted = [IMAGE_CHAR_UUID, TILE_HASH_CHAR_UUID, STATUS_CHAR_UUID, BULK_CHAR_UUID]
+    found = {}
+    for service in services:
+        if IMAGE_SERVICE_UUID.lower() in service.uuid.lower():
+            for char in service.characteristics:
+                for uuid in wanted:
+                    if uuid.lower() in char.uuid.lower():
+                        found[uuid] = char
+            break
+    return found
+
+
+async def prepare_transfer(client, chars, image_bytes, width, height, encoding, delta):
+    """压缩图像并生成头信息；设备上已有同尺寸图像时只发送变化的分块。
+    返回 (头信息, 压缩数据)，内容与设备上相同时返回 None"""
+    encoding_id, payload = encode_payload(image_bytes, encoding)
+    ratio = len(image_bytes) / max(len(payload), 1)
+    print(f"编码方式 {encoding_id}: {len(image_bytes)} -> {len(payload)} 字节 ({ratio:.1f}x)")
+
+    # 头信息：操作码、宽度、高度、编码、压缩后长度、内容哈希（小端序）
+    header = struct.pack('<BHHBII', IMAGE_OP_BEGIN, width, height, encoding_id,
+                         len(payload), payload_hash(payload))
+
+    hash_char = chars.get(TILE_HASH_CHAR_UUID)
+    if delta and hash_char:
+        base_width, base_height, base_hashes = await read_tile_hashes(client, hash_char)
+        if (base_width, base_height) == (width, height):
+            local_hashes = tile_hashes(image_bytes, width, height)
+            changed = [i for i, h in enumerate(local_hashes) if h != base_hashes[i]]
+            if not changed:
+                print("图像与设备上的内容相同，无需发送")
+                return None
+            records = build_delta_records(image_bytes, width, height, changed)
+            delta_id, delta_payload = encode_payload(records, encoding)
+            if len(records) <= IMAGE_BUFFER_SIZE and len(delta_payload) < len(payload):
+                print(f"增量传输: {len(changed)}/{len(local_hashes)} 个分块, {len(delta_payload)} 字节")
+                encoding_id, payload = delta_id, delta_payload
+                header = struct.pack('<BHHBIIH', IMAGE_OP_DELTA_BEGIN, width, height, encoding_id,
+                                     len(payload), payload_hash(payload), len(changed))
+    return header, payload
+
+
+async def read_missing_ranges(client, data_char, status_char, content_hash, payload_len):
+    """查询设备上该会话缺失的区间；返回空列表表示设备已完整接收"""
+    ranges = []
+    cursor = 0
+    while True:
+        await client.write_gatt_char(data_char, struct.pack('<BI', IMAGE_OP_QUERY, cursor), response=True)
+        status = parse_transfer_status(await client.read_gatt_char(status_char))
+        if status['hash'] != content_hash:
+            return [(0, payload_len)]
+        if status['state'] == TRANSFER_STATE_COMPLETE:
+            return []
+        batch = status['ranges']
+        ranges += batch
+        if len(batch) < TRANSFER_STATUS_RANGES_MAX:
+            return ranges
+        cursor = batch[-1][0] + batch[-1][1]
+
+
+async def send_ranges(client, chars, payload, ranges, interval, progress):
+    """按块对齐分包发送指定区间。有批量数据特征时用无应答写入 [u32 偏移][数据]，
+    否则通过控制特征发送 [操作码][u32 偏移][数据]。
+    MTU 较小时改用控制特征的长写入，每个往返携带接近512字节"""
+    bulk_char = chars.get(BULK_CHAR_UUID)
+    if client.mtu_size < LONG_WRITE_MTU:
+        bulk_char = None
+        chunk_size = (LONG_WRITE_MAX - 5) // RX_BLOCK_SIZE * RX_BLOCK_SIZE
+        print(f"MTU {client.mtu_size} 较小，使用长写入，每包 {chunk_size} 字节")
+    else:
+        prefix_len = 4 if bulk_char else 5
+        chunk_size = (min(client.mtu_size, 500) - 3 - prefix_len) // RX_BLOCK_SIZE * RX_BLOCK_SIZE
+    total = sum(length for _, length in ranges)
+    sent = 0
+    for start, length in ranges:
+        for offset in range(start, start + length, chunk_size):
+            chunk = payload[offset:min(offset + chunk_size, start + length)]
+            if bulk_char:
+                await client.write_gatt_char(bulk_char, struct.pack('<I', offset) + chunk, response=False)
+            else:
+                await client.write_gatt_char(chars[IMAGE_CHAR_UUID],
+                                             struct.pack('<BI', IMAGE_OP_DATA, offset) + chunk,
+                                             response=True)
+            sent += len(chunk)
+            progress.on_sent(sent, total)
+            if interval > 0:
+                await asyncio.sleep(interval)
+
+
+async def begin_transfer(client, data_char, status_char, header, content_hash):
+    """发送头信息。设备正在显示上一张图片且另一块缓冲区也被占用时稍后重试"""
+    for _ in range(BUSY_RETRY_MAX):
+        await client.write_gatt_char(data_char, header, response=True)
+        status = parse_transfer_status(await client.read_gatt_char(status_char))
+        if status['hash'] == content_hash or status['error'] != TRANSFER_ERROR_BUSY:
             return True
-    except Exception as e:
-        print(f"发送图像时出错: {e}")
-        return False
+        await asyncio.sleep(BUSY_RETRY_INTERVAL)
+    return False
+
+
+async def send_image(device_address, image_data, width, height, encoding='auto', interval=0.0,
+                     delta=True, retries=5, trace=None, wait_displayed=True):
+    """通过蓝牙发送图像数据到ESP32；连接断开后重新连接，只补发设备缺失的部分。
+    设备接收完成后即可发送下一张（在设备刷新屏幕的同时接收），wait_displayed 为 False 时不等待刷新结束"""
+    image_bytes = image_data.tobytes()
+    transfer = None
+    for attempt in range(retries + 1):
+        try:
+            async with BleakClient(device_address) as client:
+                print(f"已连接到: {device_address}")
+                if trace:
+                    trace.log('connect', str(client.mtu_size))
+                    client = TracingClient(client, trace)
+
+                # 检查服务和特征是否存在
+                chars = find_characteristics(await client.get_services())
+                data_char = chars.get(IMAGE_CHAR_UUID)
+                status_char = chars.get(STATUS_CHAR_UUID)
+                if not data_char or not status_char:
+                    print("未找到目标特征，请检查UUID是否正确")
+                    return False
+
+                if transfer is None:
+                    transfer = await prepare_transfer(client, chars, image_bytes, width, height,
+                                                      encoding, delta)
+                    if transfer is None:
+                        return True
+                header, payload = transfer
+                content_hash = payload_hash(payload)
+
+                # 订阅状态通知，由设备推送接收进度，不再占用屏幕刷新
+                progress = TransferProgress(content_hash)
+                notify = 'notify' in status_char.properties
+                if notify:
+                    await client.start_notify(status_char, progress.on_status)
+
+                # 相同内容哈希的未完成会话会在设备上继续
+                if not await begin_transfer(client, data_char, status_char, header, content_hash):
+                    print("设备忙，无法开始传输")
+                    return False
+                print(f"已发送头信息: {len(header)} 字节")
+
+                for _ in range(MAX_RESEND_ROUNDS):
+                    ranges = await read_missing_ranges(client, data_char, status_char,
+                                                       content_hash, len(payload))
+                    if not ranges:
+                        if notify and wait_displayed:
+                            try:
+                                await asyncio.wait_for(progress.displayed.wait(), DISPLAY_TIMEOUT)
+                            except asyncio.TimeoutError:
+                                pass
+                        progress.finish()
+                        print(f"图像数据发送完成，总大小: {len(payload) + len(header)} 字节")
+                        return True
+                    await send_ranges(client, chars, payload, ranges, interval, progress)
+                progress.finish()
+                print("设备多次未能完整接收数据")
+                return False
+        except Exception as e:
+            print(f"发送图像时出错: {e}")
+            if trace:
+                trace.log('disconnect')
+            if attempt < retries:
+                print(f"正在重新连接 ({attempt + 1}/{retries})...")
+                await asyncio.sleep(1)
+    return False
+
+def encode_text(text):
+    """编码成 UTF-8，超出设备限制时在字符边界截断"""
+    data = text.encode('utf-8')
+    if len(data) <= TEXT_MAX_BYTES:
+        return data
+    print(f"文字超过 {TEXT_MAX_BYTES} 字节，已截断")
+    return data[:TEXT_MAX_BYTES].decode('utf-8', errors='ignore').encode('utf-8')
+
+
+async def send_text(device_address, text, retries=5):
+    """让设备白底居中显示一段文字（自动换行），不等待刷新结束"""
+    frame = struct.pack('<B', IMAGE_OP_TEXT) + encode_text(text)
+    for attempt in range(retries + 1):
+        try:
+            async with BleakClient(device_address) as client:
+                print(f"已连接到: {device_address}")
+                data_char = find_characteristics(await client.get_services()).get(IMAGE_CHAR_UUID)
+                if not data_char:
+                    print("未找到目标特征，请检查UUID是否正确")
+                    return False
+                await client.write_gatt_char(data_char, frame, response=True)
+                return True
+        except Exception as e:
+            print(f"发送文字时出错: {e}")
+            if attempt < retries:
+                print(f"正在重新连接 ({attempt + 1}/{retries})...")
+                await asyncio.sleep(1)
+    return False
+
 
 async def main():
     parser = argparse.ArgumentParser(description='将图片转换为4位灰度并通过蓝牙发送到ESP32')
-    parser.add_argument('image_path', default='img.png', help='输入图片路径')
+    parser.add_argument('image_paths', nargs='*', help='输入图片路径，多张时依次发送（设备刷新时接收下一张）')
     parser.add_argument('--device', default='ESP32-EPaper', help='ESP32设备名称')
     parser.add_argument('--width', type=int, default=TARGET_WIDTH, help='目标图片宽度')
     parser.add_argument('--height', type=int, default=TARGET_HEIGHT, help='目标图片高度')
     parser.add_argument('--address', help='ESP32蓝牙地址（如果已知）')
+    parser.add_argument('--encoding', default='auto', choices=['auto', 'raw', 'rle', 'lz'],
+                        help='传输编码（auto 自动选择最小的）')
+    parser.add_argument('--interval', type=float, default=0.0, help='数据包之间的额外延迟（秒）')
+    parser.add_argument('--full', action='store_true', help='总是发送完整图像，不使用增量传输')
+    parser.add_argument('--retries', type=int, default=5, help='连接断开后的重连次数')
+    parser.add_argument('--trace-out', help='记录GATT操作到文件，供 host/gatts_sim --trace 回放')
+    parser.add_argument('--save-payload', help='只编码并保存 [头信息][压缩数据] 供 host/gatts_sim 使用，不连接设备')
+    parser.add_argument('--text', help='不发送图片，让设备显示这段文字')
     
     args = parser.parse_args()
+    if not args.image_paths and args.text is None:
+        parser.error('需要图片路径或 --text')
     
     try:
         # 转换图片
-        print(f"正在转换图片: {args.image_path}")
-        image_data, width, height = convert_to_4bit_grayscale(
-            args.image_path, args.width, args.height)
-        print(f"图片已转换为4位灰度格式: {width}x{height}, {len(image_data)} 字节")
+        images = []
+        for image_path in args.image_paths:
+            print(f"正在转换图片: {image_path}")
+            image_data, width, height = convert_to_4bit_grayscale(
+                image_path, args.width, args.height)
+            print(f"图片已转换为4位灰度格式: {width}x{height}, {len(image_data)} 字节")
+            images.append((image_data, width, height))
+
+        if args.save_payload:
+            image_data, width, height = images[0]
+            header, payload = await prepare_transfer(None, {}, image_data.tobytes(), width, height,
+                                                     args.encoding, False)
+            with open(args.save_payload, 'wb') as f:
+                f.write(header + payload)
+            print(f"已保存到: {args.save_payload}")
+            return
         
         # 查找设备
         device_address = args.address
@@ -144,13 +641,25 @@ async def main():
         if not device_address:
             print(f"未找到设备: {args.device}")
             return
+
+        if args.text is not None:
+            if await send_text(device_address, args.text, args.retries):
+                print("文字发送成功！")
+            else:
+                print("文字发送失败！")
+            return
         
-        # 发送图像
-        success = await send_image(device_address, image_data, width, height)
-        if success:
-            print("图像发送成功！")
-        else:
-            print("图像发送失败！")
+        # 发送图像：只在最后一张等待设备刷新结束，其余在设备刷新时继续发送
+        trace = TraceRecorder(args.trace_out) if args.trace_out else None
+        for i, (image_data, width, height) in enumerate(images):
+            success = await send_image(device_address, image_data, width, height,
+                                       args.encoding, args.interval, not args.full, args.retries, trace,
+                                       wait_displayed=i == len(images) - 1)
+            if success:
+                print("图像发送成功！")
+            else:
+                print("图像发送失败！")
+                break
     
     except Exception as e:
         print(f"发生错误: {e}")
@@ -4,6 +4,7 @@
 #include <esp_timer.h>
 #include <esp_types.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include <freertos/task.h>
 #include <inttypes.h>
 #include <stdio.h>
@@ -11,8 +12,19 @@
 
 #include <epdiy.h>
 #include "sdkconfig.h"
-#include "firasans_12.h"
-#include "firasans_20.h"
+#include "firasans_12_pack.h"
+#include "firasans_20_sdf.h"
+#include "image_codec.h"
+#include "tile_hash.h"
+#include "rx_session.h"
+#include "panel_power.h"
+#include "panel_temp.h"
+#include "ghost_budget.h"
+#include "glyph_cache.h"
+#include "font_partition.h"
+#include "text_render.h"
+#include "text_layout.h"
+#include "font_sdf.h"
 
 // 添加蓝牙相关头文件
 #include <nvs.h>
@@ -25,19 +37,168 @@
 // 蓝牙相关定义
 #define GATTS_SERVICE_UUID_IMAGE   0x00FF
 #define GATTS_CHAR_UUID_IMAGE_DATA 0xFF01
-#define GATTS_NUM_HANDLE_IMAGE     4
+#define GATTS_CHAR_UUID_TILE_HASH  0xFF02
+#define GATTS_CHAR_UUID_STATUS     0xFF03
+#define GATTS_CHAR_UUID_BULK_DATA  0xFF04 // 只用于批量数据：[u32 偏移][压缩数据...]，无需应答
+#define GATTS_NUM_HANDLE_IMAGE     10
+
+#define BLE_MAX_PKT_DATA_LEN 251 // LE数据长度扩展的最大值
 
 #define DEVICE_NAME "ESP32-EPaper"
 #define MANUFACTURER_DATA_LEN  4
 
+// 图像传输协议：每次写入的第一个字节为操作码，多字节字段均为小端序
+#define IMAGE_OP_BEGIN 0x01 // [op][u16 宽][u16 高][u8 编码][u32 压缩后长度][u32 内容哈希]
+#define IMAGE_OP_DATA  0x02 // [op][u32 偏移][压缩数据...]，偏移和长度按 RX_BLOCK_SIZE 对齐
+#define IMAGE_OP_DELTA_BEGIN 0x03 // 同 BEGIN，末尾追加 [u16 分块数]
+#define IMAGE_OP_QUERY 0x04 // [op][u32 偏移]，之后读取状态特征时从该偏移开始列出缺失区间
+#define IMAGE_OP_TEXT  0x05 // [op][UTF-8 文字]，白底居中显示，自动换行；不需要结尾的0，过长的部分被截断
+#define IMAGE_BEGIN_LEN 14
+#define DATA_FRAME_HEADER 5 // DATA 帧的操作码和偏移
+#define IMAGE_DELTA_BEGIN_LEN 16
+
+// 增量记录：[u16 列][u16 行][TILE_BYTES 字节分块数据]，边缘分块超出图像的部分被忽略
+#define DELTA_RECORD_LEN (4 + TILE_BYTES)
+
+// 分块哈希特征：写入 u16 起始分块序号，读取返回
+// [u16 起始][u16 个数][u16 总数][u16 分块边长][u16 宽][u16 高] + 个数 * u32 哈希
+#define TILE_HASH_PAGE_HEADER 12
+#define TILE_HASH_PAGE_MAX    120
+
+// 传输状态特征（可读，也可订阅通知）：
+// [u32 内容哈希][u32 压缩后长度][u32 已接收][u8 状态][u8 阶段][u16 区间数][u8 最近错误][u8 标志][u16 保留]
+// + 区间数 * ([u32 起始][u32 长度])。通知受 MTU 限制，只携带放得下的区间
+#define TRANSFER_STATUS_HEADER     20
+#define TRANSFER_STATUS_RANGES_MAX 60
+#define TRANSFER_STATE_IDLE        0
+#define TRANSFER_STATE_RECEIVING   1
+#define TRANSFER_STATE_COMPLETE    2
+
+#define TRANSFER_STAGE_IDLE        0
+#define TRANSFER_STAGE_RECEIVING   1 // 正在接收并流式解码
+#define TRANSFER_STAGE_DECODED     2 // 已校验，等待显示
+#define TRANSFER_STAGE_DISPLAYING  3
+#define TRANSFER_STAGE_DISPLAYED   4
+
+#define TRANSFER_FLAG_REFRESHING   0x01 // 面板正在刷新
+
+#define TRANSFER_ERROR_NONE        0
+#define TRANSFER_ERROR_HEADER      1
+#define TRANSFER_ERROR_TOO_LARGE   2
+#define TRANSFER_ERROR_NO_MEMORY   3
+#define TRANSFER_ERROR_DELTA_BASE  4
+#define TRANSFER_ERROR_DECODE      5
+#define TRANSFER_ERROR_HASH        6
+#define TRANSFER_ERROR_RANGE       7
+#define TRANSFER_ERROR_OPCODE      8
+#define TRANSFER_ERROR_BUSY        9 // 两个接收缓冲区都在等待显示，稍后重试
+
+#define STATUS_NOTIFY_INTERVAL_MS  250 // 接收过程中两次通知的最小间隔
+
 // 图像缓冲区定义
 #define IMAGE_BUFFER_SIZE (300 * 396) // 最大支持电子墨水屏分辨率大小的图片
-static uint8_t image_buffer[IMAGE_BUFFER_SIZE];
-static uint32_t image_buffer_index = 0;
-static uint32_t image_width = 0;
-static uint32_t image_height = 0;
-static bool image_header_received = false;
-static bool image_received_complete = false;
+
+// 解码后的图像放在两块 PSRAM 缓冲区中轮流使用：一张图像等待显示或正在显示时，
+// 下一张可以同时接收到另一块缓冲区
+#define IMAGE_SLOT_COUNT 2
+#define IMAGE_SLOT_FREE       0
+#define IMAGE_SLOT_RECEIVING  1
+#define IMAGE_SLOT_READY      2 // 已校验，在渲染队列中等待显示
+#define IMAGE_SLOT_DISPLAYING 3 // 显示任务正在读取，读完即释放，不必等面板刷新结束
+
+typedef struct {
+    uint8_t* data;
+    volatile uint8_t state;
+    uint32_t width;
+    uint32_t height;
+    bool delta;
+    uint16_t tile_count;
+} image_slot_t;
+
+static image_slot_t image_slots[IMAGE_SLOT_COUNT];
+
+// 渲染命令：显示任务一次取出队列中的全部命令，画入帧缓冲区后合并为一次刷新
+#define RENDER_CLEAR       0 // 清屏，同一批中之前的绘制被丢弃，它们的完成回调收到 ok = false
+#define RENDER_TEXT        1 // 白底居中显示文字，自动换行（IMAGE_OP_TEXT）
+#define RENDER_IMAGE       2 // 显示接收完成的图像缓冲区
+#define RENDER_LOG         4 // 向控制台追加一行，只局部刷新控制台区域
+#define RENDER_QUEUE_LEN   16
+#define RENDER_BATCH_MAX   32 // 一次刷新最多合并的命令数
+#define RENDER_TEXT_MAX    TEXT_LAYOUT_TEXT_MAX // 一段 IMAGE_OP_TEXT 文字可以排成多行
+#define DISPLAY_TASK_STACK    8192
+#define DISPLAY_TASK_PRIORITY 5
+#define DISPLAY_TASK_CORE     1 // 蓝牙协议栈运行在核心0
+
+// 屏幕底部的滚动日志控制台
+#define CONSOLE_LINES    3
+#define CONSOLE_MARGIN   4
+#define CONSOLE_FONT     FiraSans_12
+#define CONSOLE_FLUSH_MS 200 // 收到第一条消息后等待后续消息的时间，合并为一次刷新
+
+// RENDER_TEXT 的文字区域边距、额外行距和行高。文字用距离场字体绘制，行高可以任意设置
+#define TEXT_MARGIN       40
+#define TEXT_LINE_SPACING 8
+#define TEXT_FONT_SIZE    50
+
+// 编译进固件的字体中没有的字符（例如中文提示）用 fonts 分区中这个名称的字体绘制
+#define FALLBACK_FONT_NAME "cjk"
+
+// 完成回调在显示任务中、面板刷新结束后调用；ok 为 false 表示命令没有执行
+typedef void (*render_done_cb_t)(bool ok, void* arg);
+
+typedef struct {
+    uint8_t op;
+    int8_t slot;  // RENDER_IMAGE：image_slots 序号
+    char text[RENDER_TEXT_MAX];
+    render_done_cb_t done;
+    void* done_arg;
+} render_cmd_t;
+
+// 一批命令合并后的刷新范围
+typedef struct {
+    bool full;    // 需要整屏刷新
+    EpdRect area; // 否则只刷新这个区域
+    bool console; // 需要重绘控制台
+    bool gray;    // 有灰度内容（图像、画在图像上的文字），否则只有黑白文字，用 MODE_DU 刷新
+    bool powered;
+    int temperature;
+    int images;
+} render_batch_t;
+
+static QueueHandle_t render_queue = NULL;
+static uint32_t images_displayed = 0;
+
+static int64_t render_last_refresh_us = 0;
+static bool panel_content_unknown = false; // 快速启动后面板仍是上一张图片，高层状态却以为是白屏
+
+// 控制台内容，只在显示任务中使用
+static char console_lines[CONSOLE_LINES][RENDER_TEXT_MAX];
+static int console_next = 0;
+static int console_count = 0;
+static int image_rx_slot = -1;                 // 正在接收的缓冲区
+static uint32_t image_buffer_index = 0; // 已送入解码器的压缩数据字节数
+static uint32_t image_payload_size = 0;
+static bool image_header_received = false; // 正在接收，头信息有效
+static image_decoder_t image_decoder;
+
+// 当前显示的图像（增量传输的基准）及其分块哈希
+static uint8_t* displayed_image = NULL;
+static tile_map_t displayed_tiles;
+static bool image_on_screen = false; // 帧缓冲区内容是否仍是 displayed_image（调试信息会覆盖它），只在显示任务中使用
+static uint16_t tile_hash_cursor = 0;
+static uint32_t missing_cursor = 0;
+static uint32_t image_last_hash = 0; // 最近一次完成的会话，供发送端确认
+static uint8_t transfer_stage = TRANSFER_STAGE_IDLE;
+static uint8_t transfer_error = TRANSFER_ERROR_NONE;
+static bool panel_refreshing = false;
+static bool status_notify_enabled = false;
+static int64_t status_notify_last_us = 0;
+
+// 长写入（prepare write）的帧头和已排队的长度；DATA 以外的帧整个放在 prep_header 中，最长的是 IMAGE_OP_TEXT
+#define PREP_HEADER_MAX (1 + RENDER_TEXT_MAX)
+static uint8_t prep_header[PREP_HEADER_MAX];
+static uint16_t prep_len = 0;
+static uint16_t gatt_mtu = ESP_GATT_DEF_BLE_MTU_SIZE; // 当前连接的 ATT_MTU，每次连接从默认值开始
 
 
 // 蓝牙服务和特征句柄
@@ -46,8 +207,16 @@ static esp_gatt_if_t image_gatts_if;
 
 #define WAVEFORM EPD_BUILTIN_WAVEFORM
 
-#define epd_poweron() digitalWrite(46,1)
-#define epd_poweroff() digitalWrite(46,0)
+#define PANEL_POWER_GPIO      46
+#define PANEL_IDLE_TIMEOUT_MS 3000 // 最后一次刷新后保持供电的时间，连续刷新不必重新上电
+#define TEMP_SAMPLE_INTERVAL_MS 60000 // 温度变化很慢，定时采样并缓存
+#define GHOST_CLEAN_IDLE_MS   1000 // 最后一次刷新后空闲这么久才做残影清洁，避开连续刷新
+
+// 快速启动：先启动蓝牙广播，不清屏也不显示启动信息，电子墨水屏保留上一张图片
+#ifndef FAST_BOOT
+#define FAST_BOOT 1
+#endif
+#define DISPLAY_INIT_TASK_STACK 4096
 
 
 
@@ -69,34 +238,11 @@ const EpdDisplay_t ED060KD1 = {
     .display_type = DISPLAY_TYPE_GENERIC,
 };
 
-// 显示调试信息的通用函数
-static void display_debug_info(const char* message, bool clear_screen) {
-    if (clear_screen) {
-        epd_poweron();
-        epd_clear();
-        epd_poweroff();
-        return;
-    }
-
-    uint8_t* fb = epd_hl_get_framebuffer(&hl);
-    const EpdFont* font;
-    font = &FiraSans_20;
-    int temperature = epd_ambient_temperature();
-
-    int cursor_x = epd_rotated_display_width() / 2;
-    int cursor_y = epd_rotated_display_height() / 2;
-
-    EpdFontProperties font_props = epd_font_properties_default();
-    font_props.flags = EPD_DRAW_ALIGN_CENTER;
-
-
-    epd_hl_set_all_white(&hl);
-
-    epd_write_string(font, message, &cursor_x, &cursor_y, fb, &font_props);
-    epd_poweron();
-    epd_hl_update_screen(&hl, MODE_GL16, temperature);
-    epd_poweroff();
-    delay(3000);
+// 记录启动阶段完成的时间（自启动起的毫秒数）和自 since 起的耗时，返回当前时间供下一阶段计时
+static int64_t boot_mark(const char* stage, int64_t since) {
+    int64_t now = esp_timer_get_time();
+    ESP_LOGI("BOOT", "%-16s %6" PRId64 " ms  (+%" PRId64 " ms)", stage, now / 1000, (now - since) / 1000);
+    return now;
 }
 
 // 蓝牙广播数据
@@ -129,6 +275,7 @@ static esp_ble_adv_params_t adv_params = {
 
 // GATT服务回调函数
 static void gatts_profile_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+static void display_debug_info(const char* message, bool clear_screen);
 
 // 服务定义
 static struct gatts_profile_inst {
@@ -139,6 +286,10 @@ static struct gatts_profile_inst {
     uint16_t service_handle;
     esp_gatt_srvc_id_t service_id;
     uint16_t char_handle;
+    uint16_t hash_handle;
+    uint16_t status_handle;
+    uint16_t status_cccd_handle;
+    uint16_t bulk_handle;
     esp_bt_uuid_t char_uuid;
     esp_gatt_perm_t perm;
     esp_gatt_char_prop_t property;
@@ -159,7 +310,14 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         if (param->adv_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
             char error_msg[64];
             sprintf(error_msg, "广播启动失败: %d", param->adv_start_cmpl.status);
-        } 
+            display_debug_info(error_msg, false);
+        } else {
+            static bool advertised = false;
+            if (!advertised) {
+                advertised = true;
+                boot_mark("advertising", 0);
+            }
+        }
         break;
     default:
         break;
@@ -167,69 +325,935 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
 }
 
 
-// 处理接收到的图像数据
-static void process_received_image() {
-    if (!image_received_complete || image_width == 0 || image_height == 0) {
-        display_debug_info("data error", false);
-        return;
-    }
-    
-    display_debug_info("process...", false);
-    
-    // 获取帧缓冲区
-    uint8_t* fb = epd_hl_get_framebuffer(&hl);
-    
-    // 清空帧缓冲区
-    epd_hl_set_all_white(&hl);
-    
-    // 计算缩放比例（如果需要）
-    float scale_x = (float)epd_rotated_display_width() / image_width;
-    float scale_y = (float)epd_rotated_display_height() / image_height;
+// 控制台区域：屏幕底部 CONSOLE_LINES 行，图像布局时让出这块区域
+static EpdRect console_area(void) {
+    int height = CONSOLE_LINES * CONSOLE_FONT.advance_y + 2 * CONSOLE_MARGIN;
+    EpdRect area = {
+        .x = 0,
+        .y = epd_rotated_display_height() - height,
+        .width = epd_rotated_display_width(),
+        .height = height,
+    };
+    return area;
+}
+
+// 计算图像在屏幕上的缩放比例和居中偏移，底部留给日志控制台
+static float image_layout(uint32_t width, uint32_t height, int* offset_x, int* offset_y) {
+    int area_height = console_area().y;
+    float scale_x = (float)epd_rotated_display_width() / width;
+    float scale_y = (float)area_height / height;
     float scale = scale_x < scale_y ? scale_x : scale_y; // 取较小的缩放比例
-    
-    // 计算居中显示的偏移量
-    int offset_x = (epd_rotated_display_width() - (int)(image_width * scale)) / 2;
-    int offset_y = (epd_rotated_display_height() - (int)(image_height * scale)) / 2;
-    
-    // 将图像数据复制到帧缓冲区（这里需要根据实际图像格式进行适配）
-    // 假设图像数据是4位灰度图，每个像素占4位
-    for (int y = 0; y < image_height; y++) {
-        for (int x = 0; x < image_width; x += 2) { // 每个字节包含两个像素
-            uint8_t pixel_pair = image_buffer[(y * image_width + x) / 2];
+
+    *offset_x = (epd_rotated_display_width() - (int)(width * scale)) / 2;
+    *offset_y = (area_height - (int)(height * scale)) / 2;
+    return scale;
+}
+
+// 将图像中 [x0, x1) x [y0, y1) 区域绘制到帧缓冲区，返回屏幕上被改写的区域
+static EpdRect draw_image_region(const uint8_t* image, uint32_t width, uint32_t height,
+                                 uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    uint8_t* fb = epd_hl_get_framebuffer(&hl);
+    int offset_x, offset_y;
+    float scale = image_layout(width, height, &offset_x, &offset_y);
+
+    // 将图像数据复制到帧缓冲区
+    // 图像数据是4位灰度图，每个像素占4位
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x += 2) { // 每个字节包含两个像素
+            uint8_t pixel_pair = image[(y * width + x) / 2];
             uint8_t pixel1 = (pixel_pair >> 4) & 0x0F; // 高4位
             uint8_t pixel2 = pixel_pair & 0x0F;        // 低4位
-            
+
             // 计算目标位置（考虑缩放和居中）
             int target_x1 = offset_x + (int)(x * scale);
             int target_x2 = offset_x + (int)((x + 1) * scale);
             int target_y = offset_y + (int)(y * scale);
-            
+
             // 确保坐标在有效范围内
-            if (target_x1 >= 0 && target_x1 < epd_rotated_display_width() && 
+            if (target_x1 >= 0 && target_x1 < epd_rotated_display_width() &&
                 target_y >= 0 && target_y < epd_rotated_display_height()) {
                 // 将4位灰度值转换为8位灰度值
                 uint8_t gray1 = (pixel1 << 4) | pixel1; // 扩展到8位
                 epd_draw_pixel(target_x1, target_y, gray1, fb);
             }
-            
-            if (target_x2 >= 0 && target_x2 < epd_rotated_display_width() && 
+
+            if (target_x2 >= 0 && target_x2 < epd_rotated_display_width() &&
                 target_y >= 0 && target_y < epd_rotated_display_height()) {
                 uint8_t gray2 = (pixel2 << 4) | pixel2; // 扩展到8位
                 epd_draw_pixel(target_x2, target_y, gray2, fb);
             }
         }
     }
-    
-    // 更新显示
-    int temperature = epd_ambient_temperature();
-    epd_poweron();
-    epd_hl_update_screen(&hl, MODE_GL16, temperature);
-    epd_poweroff();
-    
-    // 重置状态，准备接收下一张图片
+
+    EpdRect area = {
+        .x = offset_x + (int)(x0 * scale),
+        .y = offset_y + (int)(y0 * scale),
+    };
+    area.width = offset_x + (int)((x1 - 1) * scale) + 1 - area.x;
+    area.height = offset_y + (int)((y1 - 1) * scale) + 1 - area.y;
+    return area;
+}
+
+// 合并两个屏幕区域
+static EpdRect rect_union(EpdRect a, EpdRect b) {
+    if (a.width == 0 || a.height == 0) {
+        return b;
+    }
+    int x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+    int y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+    a.x = a.x < b.x ? a.x : b.x;
+    a.y = a.y < b.y ? a.y : b.y;
+    a.width = x1 - a.x;
+    a.height = y1 - a.y;
+    return a;
+}
+
+// 将增量记录应用到当前显示的图像，返回屏幕上需要刷新的区域
+static EpdRect apply_delta_tiles(const image_slot_t* slot) {
+    EpdRect area = {0};
+    uint32_t image_width = slot->width;
+    uint32_t image_height = slot->height;
+    const uint8_t* record = slot->data;
+    for (uint16_t i = 0; i < slot->tile_count; i++, record += DELTA_RECORD_LEN) {
+        uint16_t col = record[0] | (record[1] << 8);
+        uint16_t row = record[2] | (record[3] << 8);
+        if (col >= displayed_tiles.cols || row >= displayed_tiles.rows) {
+            continue;
+        }
+        tile_map_copy_in(&displayed_tiles, displayed_image, col, row, record + 4);
+        tile_map_update(&displayed_tiles, displayed_image, col, row);
+
+        uint32_t x0 = col * TILE_SIZE;
+        uint32_t y0 = row * TILE_SIZE;
+        uint32_t x1 = x0 + TILE_SIZE < image_width ? x0 + TILE_SIZE : image_width;
+        uint32_t y1 = y0 + TILE_SIZE < image_height ? y0 + TILE_SIZE : image_height;
+        area = rect_union(area, draw_image_region(displayed_image, image_width, image_height, x0, y0, x1, y1));
+    }
+    return area;
+}
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+// 生成传输状态：当前（或刚完成的）会话，以及从 from 开始最多 max_ranges 个缺失区间，返回长度
+static uint16_t build_transfer_status(uint8_t* page, uint32_t from, int max_ranges) {
+    uint32_t starts[TRANSFER_STATUS_RANGES_MAX];
+    uint32_t lens[TRANSFER_STATUS_RANGES_MAX];
+    int count = 0;
+
+    memset(page, 0, TRANSFER_STATUS_HEADER);
+    if (rx_session_active()) {
+        const rx_session_desc_t* desc = rx_session_desc();
+        if (max_ranges > 0) {
+            count = rx_session_missing(from, starts, lens, max_ranges);
+        }
+        put_u32(page, desc->hash);
+        put_u32(page + 4, desc->payload_size);
+        put_u32(page + 8, rx_session_received());
+        page[12] = TRANSFER_STATE_RECEIVING;
+    } else if (image_last_hash != 0) {
+        put_u32(page, image_last_hash);
+        page[12] = TRANSFER_STATE_COMPLETE;
+    }
+    page[13] = transfer_stage;
+    put_u16(page + 14, count);
+    page[16] = transfer_error;
+    page[17] = panel_refreshing ? TRANSFER_FLAG_REFRESHING : 0;
+    for (int i = 0; i < count; i++) {
+        put_u32(page + TRANSFER_STATUS_HEADER + i * 8, starts[i]);
+        put_u32(page + TRANSFER_STATUS_HEADER + i * 8 + 4, lens[i]);
+    }
+    return TRANSFER_STATUS_HEADER + count * 8;
+}
+
+// 向订阅的发送端推送传输状态。接收过程中按 STATUS_NOTIFY_INTERVAL_MS 限速，状态变化时用 force 立即发送。
+// 显示任务中调用时不带缺失区间（with_ranges 为 false），避免与蓝牙任务同时遍历接收位图
+static void notify_transfer_status(bool force, bool with_ranges) {
+    static uint8_t page[TRANSFER_STATUS_HEADER + TRANSFER_STATUS_RANGES_MAX * 8]; // 只在蓝牙任务中使用
+    uint8_t header[TRANSFER_STATUS_HEADER];
+
+    if (!status_notify_enabled) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (!force && now - status_notify_last_us < STATUS_NOTIFY_INTERVAL_MS * 1000LL) {
+        return;
+    }
+    status_notify_last_us = now;
+
+    // 通知最多 ATT_MTU - 3 字节，按当前连接的 MTU 决定能带上的区间数
+    int max_ranges = 0;
+    if (with_ranges && gatt_mtu - 3 > TRANSFER_STATUS_HEADER) {
+        max_ranges = (gatt_mtu - 3 - TRANSFER_STATUS_HEADER) / 8;
+        if (max_ranges > TRANSFER_STATUS_RANGES_MAX) {
+            max_ranges = TRANSFER_STATUS_RANGES_MAX;
+        }
+    }
+    uint8_t* value = with_ranges ? page : header;
+    uint16_t len = build_transfer_status(value, 0, max_ranges);
+    esp_ble_gatts_send_indicate(image_profile_tab.gatts_if, image_profile_tab.conn_id,
+                                image_profile_tab.status_handle, len, value, false);
+}
+
+// 是否有图像等待显示或正在读取。此时 displayed_image 即将改变，不能作为增量传输的基准
+static bool image_display_pending(void) {
+    for (int i = 0; i < IMAGE_SLOT_COUNT; i++) {
+        if (image_slots[i].state == IMAGE_SLOT_READY || image_slots[i].state == IMAGE_SLOT_DISPLAYING) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 显示阶段只在没有新的传输时更新，接收下一张图片时以接收进度为准
+static void set_display_stage(uint8_t stage) {
+    if (!image_header_received) {
+        transfer_stage = stage;
+    }
+}
+
+// 提交渲染命令，不等待刷新；完成后在显示任务中调用 cmd->done。队列满时返回 false
+static bool render_submit(const render_cmd_t* cmd) {
+    return render_queue != NULL && xQueueSend(render_queue, cmd, 0) == pdTRUE;
+}
+
+// 白底绘制文字：在控制台以上的区域内自动换行，水平和垂直居中。mono 时只画黑白两色
+static void render_draw_text(const char* text, bool mono) {
+    uint8_t* fb = epd_hl_get_framebuffer(&hl);
+    EpdRect box = {
+        .x = TEXT_MARGIN,
+        .y = TEXT_MARGIN,
+        .width = epd_rotated_display_width() - 2 * TEXT_MARGIN,
+        .height = console_area().y - 2 * TEXT_MARGIN,
+    };
+
+    const EpdFont* font = font_sdf_get(&FiraSans_20Sdf, TEXT_FONT_SIZE);
+    if (font == NULL) {
+        font = &CONSOLE_FONT;
+    }
+
+    epd_hl_set_all_white(&hl);
+    const text_layout_t* layout =
+        text_layout_get(font, text, box, EPD_DRAW_ALIGN_CENTER | TEXT_LAYOUT_MIDDLE, TEXT_LINE_SPACING);
+    if (layout != NULL) {
+        EpdFontProperties props = epd_font_properties_default();
+        if (mono) {
+            props.flags |= TEXT_DRAW_MONO;
+        }
+        text_layout_draw(layout, fb, &props);
+    }
+    image_on_screen = false;
+}
+
+// 把接收完成的图像读入 displayed_image 和帧缓冲区，然后立即释放缓冲区，
+// 面板刷新期间两块缓冲区都可以用于接收。返回 false 表示内存不足
+static bool render_draw_image(image_slot_t* slot, render_batch_t* batch) {
+    uint32_t image_width = slot->width;
+    uint32_t image_height = slot->height;
+
+    set_display_stage(TRANSFER_STAGE_DISPLAYING);
+    if (slot->delta) {
+        // 增量更新：帧缓冲区中仍是当前图像时只刷新变化的分块
+        bool partial = image_on_screen;
+        if (!partial) {
+            epd_hl_set_all_white(&hl);
+            draw_image_region(displayed_image, image_width, image_height, 0, 0, image_width, image_height);
+        }
+        EpdRect area = apply_delta_tiles(slot);
+        slot->state = IMAGE_SLOT_FREE;
+        if (partial) {
+            batch->area = rect_union(batch->area, area);
+        } else {
+            batch->full = true;
+        }
+    } else {
+        uint32_t image_size = (image_width * image_height + 1) / 2;
+        if (displayed_image == NULL) {
+            displayed_image = heap_caps_malloc(IMAGE_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+        }
+        if (displayed_image == NULL || !tile_map_reset(&displayed_tiles, image_width, image_height)) {
+            ESP_LOGW("DISPLAY", "error: no memory");
+            slot->state = IMAGE_SLOT_FREE;
+            set_display_stage(TRANSFER_STAGE_IDLE);
+            transfer_error = TRANSFER_ERROR_NO_MEMORY;
+            image_on_screen = false;
+            return false;
+        }
+        memcpy(displayed_image, slot->data, image_size);
+        tile_map_update_all(&displayed_tiles, displayed_image);
+        slot->state = IMAGE_SLOT_FREE;
+
+        // 清空帧缓冲区
+        epd_hl_set_all_white(&hl);
+        draw_image_region(displayed_image, image_width, image_height, 0, 0, image_width, image_height);
+        batch->full = true;
+    }
+    image_on_screen = true;
+    return true;
+}
+
+// 图像命令完成：刷新结束后更新显示阶段，状态通知由批次统一发送。ok 为 false 时图像没有显示出来
+// （解码失败或被同一批中之后的清屏丢弃）
+static void image_render_done(bool ok, void* arg) {
+    (void)arg;
+    if (ok) {
+        images_displayed++;
+        set_display_stage(TRANSFER_STAGE_DISPLAYED);
+    } else {
+        set_display_stage(TRANSFER_STAGE_IDLE);
+    }
+}
+
+// 追加一行到控制台，最旧的一行滚出
+static void console_append(const char* text) {
+    snprintf(console_lines[console_next], RENDER_TEXT_MAX, "%s", text);
+    console_next = (console_next + 1) % CONSOLE_LINES;
+    if (console_count < CONSOLE_LINES) {
+        console_count++;
+    }
+}
+
+// 在帧缓冲区中重绘控制台，返回其区域。mono 时只画黑白两色
+static EpdRect console_draw(bool mono) {
+    uint8_t* fb = epd_hl_get_framebuffer(&hl);
+    EpdRect area = console_area();
+    epd_fill_rect(area, 0xFF, fb);
+    EpdFontProperties props = epd_font_properties_default();
+    if (mono) {
+        props.flags |= TEXT_DRAW_MONO;
+    }
+
+    // 每行一个排版结果，超出宽度的部分不画；没有变化的行直接用缓存的排版
+    int first = (console_next - console_count + CONSOLE_LINES) % CONSOLE_LINES;
+    for (int i = 0; i < console_count; i++) {
+        EpdRect line = {
+            .x = area.x + CONSOLE_MARGIN,
+            .y = area.y + CONSOLE_MARGIN + i * CONSOLE_FONT.advance_y,
+            .width = area.width - 2 * CONSOLE_MARGIN,
+            .height = CONSOLE_FONT.advance_y,
+        };
+        const text_layout_t* layout =
+            text_layout_get(&CONSOLE_FONT, console_lines[(first + i) % CONSOLE_LINES], line, EPD_DRAW_ALIGN_LEFT, 0);
+        if (layout != NULL) {
+            text_layout_draw(layout, fb, &props);
+        }
+    }
+    return area;
+}
+
+// 整个屏幕（旋转后的坐标）
+static EpdRect screen_area(void) {
+    EpdRect area = {.x = 0, .y = 0, .width = epd_rotated_display_width(), .height = epd_rotated_display_height()};
+    return area;
+}
+
+// 清洁刷新：区域先闪成白色，再用 GC16 把帧缓冲区的内容完整画回去。面板需已上电。
+// 横向时旋转后的坐标与缓冲区一致
+static void render_clean_area(EpdRect area, int temperature) {
+    // 按字节对齐，帧缓冲区每字节两个像素
+    area.width += area.x & 1;
+    area.x &= ~1;
+    area.width = (area.width + 1) & ~1;
+    if (area.x + area.width > epd_width()) {
+        area.width = epd_width() - area.x;
+    }
+
+    epd_clear_area(area);
+    // 面板上这块区域现在是白色，同步高层状态的屏幕缓冲区，GC16 才会重画区域内的每个像素
+    for (int y = area.y; y < area.y + area.height; y++) {
+        memset(hl.back_fb + y * epd_width() / 2 + area.x / 2, 0xFF, area.width / 2);
+    }
+    epd_hl_update_area(&hl, MODE_GC16, temperature, area);
+    ghost_budget_reset(area);
+    ESP_LOGI("DISPLAY", "ghost clean %dx%d at (%d, %d)", area.width, area.height, area.x, area.y);
+}
+
+// 面板上电；重新上电后在这批刷新结束时补采一次温度
+static void render_power_on(render_batch_t* batch) {
+    if (!batch->powered) {
+        if (panel_power_acquire()) {
+            panel_temp_request();
+        }
+        batch->powered = true;
+    }
+}
+
+// 把一条命令画入帧缓冲区并记录到批次中
+static bool render_apply(const render_cmd_t* cmd, render_batch_t* batch) {
+    switch (cmd->op) {
+    case RENDER_CLEAR:
+        // 同时重置高层状态的屏幕缓冲区，之后的差分刷新以白屏为基准；控制台一并清空
+        render_power_on(batch);
+        epd_fullclear(&hl, batch->temperature);
+        ghost_budget_reset(screen_area());
+        panel_content_unknown = false;
+        image_on_screen = false;
+        console_count = 0;
+        batch->full = false;
+        batch->console = false;
+        batch->gray = false;
+        batch->area = (EpdRect){0};
+        return true;
+    case RENDER_TEXT:
+        // 屏幕上是图像时 MODE_DU 会留下明显的残影，仍然用抗锯齿文字和灰度刷新
+        batch->gray |= image_on_screen;
+        render_draw_text(cmd->text, !batch->gray);
+        batch->full = true;
+        batch->console = true; // 整屏重画会擦掉控制台
+        return true;
+    case RENDER_IMAGE:
+        if (batch->images == 0) {
+            panel_refreshing = true;
+            notify_transfer_status(true, false);
+        }
+        batch->images++;
+        batch->gray = true;
+        if (!render_draw_image(&image_slots[cmd->slot], batch)) {
+            return false;
+        }
+        batch->console |= batch->full;
+        return true;
+    case RENDER_LOG:
+        console_append(cmd->text);
+        batch->console = true;
+        return true;
+    }
+    return false;
+}
+
+// 执行一批渲染命令：先等待第一条，再取出队列中已有的命令一起画入帧缓冲区，最后只刷新一次。
+// 批次中有控制台消息时再多等待 CONSOLE_FLUSH_MS，把一串消息合并成一次局部刷新。
+// 清屏之前的绘制不再刷新；返回 false 表示等待超时
+static bool render_process_batch(TickType_t wait) {
+    render_done_cb_t done[RENDER_BATCH_MAX];
+    void* done_arg[RENDER_BATCH_MAX];
+    bool ok[RENDER_BATCH_MAX];
+    render_batch_t batch = {0};
+    render_cmd_t cmd;
+    int count = 0;
+    int64_t log_since = -1;
+
+    if (render_queue == NULL || xQueueReceive(render_queue, &cmd, wait) != pdTRUE) {
+        return false;
+    }
+    batch.temperature = panel_temp_get();
+    do {
+        if (cmd.op == RENDER_LOG && log_since < 0) {
+            log_since = esp_timer_get_time();
+        }
+        if (cmd.op == RENDER_CLEAR) {
+            // 之前画入帧缓冲区的内容不会出现在屏幕上，这些命令按没有执行完成
+            for (int i = 0; i < count; i++) {
+                ok[i] = false;
+            }
+        }
+        done[count] = cmd.done;
+        done_arg[count] = cmd.done_arg;
+        ok[count] = render_apply(&cmd, &batch);
+        count++;
+
+        TickType_t next_wait = 0;
+        if (log_since >= 0) {
+            int64_t remaining_ms = CONSOLE_FLUSH_MS - (esp_timer_get_time() - log_since) / 1000;
+            next_wait = remaining_ms > 0 ? pdMS_TO_TICKS(remaining_ms) : 0;
+        }
+        if (count >= RENDER_BATCH_MAX || xQueueReceive(render_queue, &cmd, next_wait) != pdTRUE) {
+            break;
+        }
+    } while (1);
+
+    if (batch.console && console_count > 0) {
+        EpdRect area = console_draw(!batch.gray);
+        if (!batch.full) {
+            batch.area = rect_union(batch.area, area);
+        }
+    }
+    // 只有黑白文字变化时用快速的 MODE_DU
+    enum EpdDrawMode mode = batch.gray ? MODE_GL16 : MODE_DU;
+    if (panel_content_unknown) {
+        // 差分刷新会漏掉旧图片中需要变白的像素，第一次整屏刷新改为清洁刷新；
+        // 在此之前的局部刷新（控制台）先不刷，保留屏幕上的旧图片
+        if (batch.full) {
+            render_power_on(&batch);
+            render_clean_area(screen_area(), batch.temperature);
+            panel_content_unknown = false;
+        }
+    } else if (batch.full) {
+        render_power_on(&batch);
+        epd_hl_update_screen(&hl, mode, batch.temperature);
+        ghost_budget_charge(screen_area(), mode, !batch.gray);
+    } else if (batch.area.width > 0 && batch.area.height > 0) {
+        render_power_on(&batch);
+        epd_hl_update_area(&hl, mode, batch.temperature, batch.area);
+        ghost_budget_charge(batch.area, mode, !batch.gray);
+    }
+    // 残影超过硬上限时不再等待空闲，趁面板还在供电立即清洁
+    EpdRect ghost_area;
+    if (batch.powered && ghost_budget_pending(true, &ghost_area)) {
+        render_clean_area(ghost_area, batch.temperature);
+    }
+    if (batch.powered) {
+        render_last_refresh_us = esp_timer_get_time();
+        panel_power_release();
+    }
+    if (count > 1) {
+        ESP_LOGI("DISPLAY", "%d render commands in one refresh", count);
+    }
+
+    panel_refreshing = false;
+    for (int i = 0; i < count; i++) {
+        if (done[i] != NULL) {
+            done[i](ok[i], done_arg[i]);
+        }
+    }
+    if (batch.images > 0) {
+        notify_transfer_status(true, false);
+    }
+    return true;
+}
+
+// 距离残影清洁的毫秒数，没有超出预算的区域时返回 -1
+static int32_t ghost_clean_due_ms(EpdRect* area) {
+    if (!ghost_budget_pending(false, area)) {
+        return -1;
+    }
+    int64_t idle_ms = (esp_timer_get_time() - render_last_refresh_us) / 1000;
+    return idle_ms >= GHOST_CLEAN_IDLE_MS ? 0 : (int32_t)(GHOST_CLEAN_IDLE_MS - idle_ms);
+}
+
+// 没有渲染命令时的维护工作：到期的残影清洁，然后是空闲断电
+static void display_idle(void) {
+    EpdRect area;
+    if (ghost_clean_due_ms(&area) == 0) {
+        if (panel_power_acquire()) {
+            panel_temp_request();
+        }
+        render_clean_area(area, panel_temp_get());
+        render_last_refresh_us = esp_timer_get_time();
+        panel_power_release();
+        return;
+    }
+    panel_power_idle();
+}
+
+// 等待下一批命令的时间：最多等到残影清洁、空闲断电或下一次温度采样的时刻
+static TickType_t display_wait_ticks(void) {
+    EpdRect area;
+    int32_t remaining_ms = panel_temp_due_ms();
+    int32_t idle_ms = panel_power_idle_remaining_ms();
+    int32_t ghost_ms = ghost_clean_due_ms(&area);
+    if (idle_ms >= 0 && idle_ms < remaining_ms) {
+        remaining_ms = idle_ms;
+    }
+    if (ghost_ms >= 0 && ghost_ms < remaining_ms) {
+        remaining_ms = ghost_ms;
+    }
+    return remaining_ms > 0 ? pdMS_TO_TICKS(remaining_ms) + 1 : 0;
+}
+
+// 显示任务：独占帧缓冲区和面板电源，其他任务只通过 render_queue 提交命令。
+// 温度采样也放在这里，不占用刷新前的时间
+static void display_task(void* arg) {
+    (void)arg;
+    while (1) {
+        if (!render_process_batch(display_wait_ticks())) {
+            display_idle();
+        }
+        panel_temp_poll();
+    }
+}
+
+// 创建渲染队列并启动显示任务，需在 epd_hl_init 之后调用
+static bool display_task_start(void) {
+    render_queue = xQueueCreate(RENDER_QUEUE_LEN, sizeof(render_cmd_t));
+    if (render_queue == NULL) {
+        return false;
+    }
+    return xTaskCreatePinnedToCore(display_task, "display", DISPLAY_TASK_STACK, NULL, DISPLAY_TASK_PRIORITY, NULL,
+                                   DISPLAY_TASK_CORE) == pdPASS;
+}
+
+// 显示调试信息的通用函数：清屏，或向控制台追加一行。只提交给显示任务，不等待刷新
+static void display_debug_info(const char* message, bool clear_screen) {
+    render_cmd_t cmd = {.op = clear_screen ? RENDER_CLEAR : RENDER_LOG};
+    if (!clear_screen) {
+        snprintf(cmd.text, RENDER_TEXT_MAX, "%s", message);
+    }
+    if (!render_submit(&cmd)) {
+        ESP_LOGW("DISPLAY", "render queue full or not started, dropped: %s", message);
+    }
+}
+
+// 白底居中显示一段文字，截断时不留下半个 UTF-8 字符。只提交给显示任务，队列满时返回 false
+static bool display_show_text(const uint8_t* text, uint16_t len) {
+    render_cmd_t cmd = {.op = RENDER_TEXT};
+    if (len >= RENDER_TEXT_MAX) {
+        len = RENDER_TEXT_MAX - 1;
+        while (len > 0 && (text[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    memcpy(cmd.text, text, len);
+    cmd.text[len] = 0;
+    return render_submit(&cmd);
+}
+
+// 分配接收缓冲区
+static bool image_slots_init(void) {
+    for (int i = 0; i < IMAGE_SLOT_COUNT; i++) {
+        image_slots[i].data = heap_caps_malloc(IMAGE_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+        image_slots[i].state = IMAGE_SLOT_FREE;
+        if (image_slots[i].data == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 记录错误并通知发送端，错误追加到屏幕底部的控制台，不清屏
+static void image_rx_error(uint8_t error, const char* message) {
+    ESP_LOGW("GATTS", "%s", message);
+    display_debug_info(message, false);
+    transfer_error = error;
+    notify_transfer_status(true, true);
+}
+
+// 接收失败：丢弃会话并释放缓冲区，发送端需要重新开始
+static void image_rx_fail(uint8_t error, const char* message) {
+    rx_session_finish();
     image_header_received = false;
-    image_received_complete = false;
+    if (image_rx_slot >= 0) {
+        image_slots[image_rx_slot].state = IMAGE_SLOT_FREE;
+        image_rx_slot = -1;
+    }
+    transfer_stage = TRANSFER_STAGE_IDLE;
+    image_rx_error(error, message);
+}
+
+// 把已连续收到的压缩数据送入解码器，全部到齐后校验哈希
+static void image_rx_pump(void) {
+    uint32_t available = rx_session_contiguous();
+    if (available > image_buffer_index) {
+        image_decode_status_t status = image_decoder_feed(&image_decoder, rx_session_payload() + image_buffer_index,
+                                                          available - image_buffer_index);
+        image_buffer_index = available;
+        if (status == IMAGE_DECODE_ERROR) {
+            image_rx_fail(TRANSFER_ERROR_DECODE, "error: decode");
+            return;
+        }
+    }
+
+    // 检查是否接收完成
+    if (image_buffer_index == image_payload_size) {
+        if (image_decoder_output_size(&image_decoder) != image_decoder.out_len) {
+            image_rx_fail(TRANSFER_ERROR_DECODE, "error: decode");
+            return;
+        }
+        if (!rx_session_verify()) {
+            image_rx_fail(TRANSFER_ERROR_HASH, "error: hash");
+            return;
+        }
+        image_last_hash = rx_session_desc()->hash;
+        rx_session_finish();
+        image_header_received = false;
+        transfer_stage = TRANSFER_STAGE_DECODED;
+
+        // 交给显示任务，之后的 BEGIN 使用另一块缓冲区
+        render_cmd_t cmd = {.op = RENDER_IMAGE, .slot = image_rx_slot, .done = image_render_done};
+        image_slots[image_rx_slot].state = IMAGE_SLOT_READY;
+        if (!render_submit(&cmd)) {
+            image_slots[image_rx_slot].state = IMAGE_SLOT_FREE;
+            transfer_stage = TRANSFER_STAGE_IDLE;
+            transfer_error = TRANSFER_ERROR_BUSY;
+        }
+        image_rx_slot = -1;
+        notify_transfer_status(true, true);
+        return;
+    }
+    notify_transfer_status(false, true);
+}
+
+// 开始接收一张新图片或一组增量分块：解析头信息并初始化流式解码器
+// 内容哈希与未完成的会话一致时继续该会话，只需补发缺失的数据
+static void image_rx_begin(const uint8_t* data, uint16_t len, bool delta) {
+    if (len < (delta ? IMAGE_DELTA_BEGIN_LEN : IMAGE_BEGIN_LEN) - 1) {
+        image_rx_error(TRANSFER_ERROR_HEADER, "error: header");
+        return;
+    }
+    rx_session_desc_t desc = {
+        .width = data[0] | (data[1] << 8),
+        .height = data[2] | (data[3] << 8),
+        .encoding = data[4],
+        .payload_size = data[5] | (data[6] << 8) | (data[7] << 16) | ((uint32_t)data[8] << 24),
+        .hash = data[9] | (data[10] << 8) | (data[11] << 16) | ((uint32_t)data[12] << 24),
+        .delta = delta,
+    };
+    uint32_t expected_size = ((uint32_t)desc.width * desc.height + 1) / 2; // 4位灰度图，每个像素占4位
+
+    if (delta) {
+        // 增量数据以当前显示的图像为基准，尺寸必须一致
+        desc.tile_count = data[13] | (data[14] << 8);
+        if (image_display_pending()) {
+            image_rx_error(TRANSFER_ERROR_BUSY, "error: busy");
+            return;
+        }
+        if (displayed_image == NULL || desc.width != displayed_tiles.width || desc.height != displayed_tiles.height) {
+            image_rx_error(TRANSFER_ERROR_DELTA_BASE, "error: delta base");
+            return;
+        }
+        expected_size = (uint32_t)desc.tile_count * DELTA_RECORD_LEN;
+    }
+
+    if (desc.width == 0 || desc.height == 0 || (desc.width & 1) || expected_size == 0 ||
+        expected_size > IMAGE_BUFFER_SIZE || desc.payload_size == 0 || desc.payload_size > RX_PAYLOAD_MAX) {
+        image_rx_error(TRANSFER_ERROR_TOO_LARGE, "error: data large");
+        return;
+    }
+
+    // 新的传输覆盖正在接收的缓冲区；没有时取一块空闲的，两块都在等待显示则让发送端稍后重试
+    int slot = image_rx_slot;
+    for (int i = 0; slot < 0 && i < IMAGE_SLOT_COUNT; i++) {
+        if (image_slots[i].state == IMAGE_SLOT_FREE) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        image_rx_error(TRANSFER_ERROR_BUSY, "error: busy");
+        return;
+    }
+
+    bool resumed = rx_session_begin(&desc);
+    if (!rx_session_active()) {
+        image_rx_error(TRANSFER_ERROR_NO_MEMORY, "error: no memory");
+        return;
+    }
+    if (resumed && image_header_received) {
+        // 同一会话的解码器仍然有效，直接继续
+        return;
+    }
+
+    image_rx_slot = slot;
+    image_slots[slot].state = IMAGE_SLOT_RECEIVING;
+    image_slots[slot].width = desc.width;
+    image_slots[slot].height = desc.height;
+    image_slots[slot].delta = delta;
+    image_slots[slot].tile_count = desc.tile_count;
+    image_payload_size = desc.payload_size;
     image_buffer_index = 0;
+    image_decoder_init(&image_decoder, desc.encoding, image_slots[slot].data, expected_size);
+    image_header_received = true;
+    transfer_stage = TRANSFER_STAGE_RECEIVING;
+    transfer_error = TRANSFER_ERROR_NONE;
+    ESP_LOGI("GATTS", resumed ? "resume: %dx%d" : "receive: %dx%d", (int)desc.width, (int)desc.height);
+    notify_transfer_status(true, true);
+
+    // 恢复的会话（例如重启后）可能已有数据，先解码这一部分
+    image_rx_pump();
+}
+
+// 写入一段压缩数据：[u32 偏移][数据]，可以乱序或重复到达
+static void image_rx_data(const uint8_t* data, uint16_t len) {
+    if (!image_header_received || len < 4) {
+        return;
+    }
+    uint32_t offset = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+    if (!rx_session_write(offset, data + 4, len - 4)) {
+        image_rx_fail(TRANSFER_ERROR_RANGE, "error: max");
+        return;
+    }
+    image_rx_pump();
+}
+
+// 处理控制特征上的一次完整写入（普通写入或执行后的长写入）
+static void image_handle_control(const uint8_t* value, uint16_t len) {
+    if (len == 0) {
+        return;
+    }
+    switch (value[0]) {
+    case IMAGE_OP_BEGIN:
+        image_rx_begin(value + 1, len - 1, false);
+        break;
+    case IMAGE_OP_DELTA_BEGIN:
+        image_rx_begin(value + 1, len - 1, true);
+        break;
+    case IMAGE_OP_DATA:
+        image_rx_data(value + 1, len - 1);
+        break;
+    case IMAGE_OP_QUERY:
+        if (len >= 5) {
+            missing_cursor = value[1] | (value[2] << 8) | (value[3] << 16) | ((uint32_t)value[4] << 24);
+        }
+        break;
+    case IMAGE_OP_TEXT:
+        if (!display_show_text(value + 1, len - 1)) {
+            image_rx_error(TRANSFER_ERROR_BUSY, "error: busy");
+        }
+        break;
+    default:
+        image_rx_error(TRANSFER_ERROR_OPCODE, "error: opcode");
+        break;
+    }
+}
+
+// 长写入片段：帧头保存在 prep_header 中；DATA 帧的数据部分直接暂存到接收缓冲区（已收到的块不受影响），
+// 执行写入时只需标记，不再复制。片段必须按偏移顺序到达
+static esp_gatt_status_t image_prep_write(uint16_t offset, const uint8_t* value, uint16_t len) {
+    if (offset != prep_len) {
+        return ESP_GATT_INVALID_OFFSET;
+    }
+    for (uint16_t i = 0; i < len && offset + i < PREP_HEADER_MAX; i++) {
+        prep_header[offset + i] = value[i];
+    }
+
+    uint32_t end = offset + len;
+    if (end >= DATA_FRAME_HEADER && prep_header[0] == IMAGE_OP_DATA) {
+        uint32_t frame_offset = prep_header[1] | (prep_header[2] << 8) | (prep_header[3] << 16) |
+                                ((uint32_t)prep_header[4] << 24);
+        uint32_t skip = offset < DATA_FRAME_HEADER ? DATA_FRAME_HEADER - offset : 0;
+        if (!image_header_received ||
+            !rx_session_stage(frame_offset + offset + skip - DATA_FRAME_HEADER, value + skip, len - skip)) {
+            return ESP_GATT_INVALID_OFFSET;
+        }
+    } else if (end > PREP_HEADER_MAX) {
+        return ESP_GATT_INVALID_ATTR_LEN;
+    }
+    prep_len = end;
+    return ESP_GATT_OK;
+}
+
+// 执行或取消排队的长写入
+static void image_exec_write(bool commit) {
+    if (commit && prep_len > 0) {
+        if (prep_header[0] == IMAGE_OP_DATA && prep_len >= DATA_FRAME_HEADER) {
+            uint32_t frame_offset = prep_header[1] | (prep_header[2] << 8) | (prep_header[3] << 16) |
+                                    ((uint32_t)prep_header[4] << 24);
+            if (!image_header_received ||
+                !rx_session_mark(frame_offset, prep_len - DATA_FRAME_HEADER)) {
+                image_rx_fail(TRANSFER_ERROR_RANGE, "error: max");
+            } else {
+                image_rx_pump();
+            }
+        } else {
+            image_handle_control(prep_header, prep_len);
+        }
+    }
+    prep_len = 0;
+}
+
+// 以长读取的方式返回一段属性值：从请求的偏移开始，最多 MTU - 1 字节
+static void send_read_response(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param,
+                               const uint8_t* value, uint16_t value_len) {
+    if (param->read.offset > value_len) {
+        esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, ESP_GATT_INVALID_OFFSET, NULL);
+        return;
+    }
+    esp_gatt_rsp_t rsp;
+    memset(&rsp, 0, sizeof(rsp));
+    rsp.attr_value.handle = param->read.handle;
+    rsp.attr_value.offset = param->read.offset;
+    uint16_t len = value_len - param->read.offset;
+    if (len > gatt_mtu - 1) {
+        len = gatt_mtu - 1;
+    }
+    rsp.attr_value.len = len;
+    memcpy(rsp.attr_value.value, value + param->read.offset, len);
+    esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, ESP_GATT_OK, &rsp);
+}
+
+// 读取传输状态：从 missing_cursor 开始列出缺失区间
+static void send_transfer_status(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param) {
+    static uint8_t page[TRANSFER_STATUS_HEADER + TRANSFER_STATUS_RANGES_MAX * 8];
+    uint16_t len = build_transfer_status(page, missing_cursor, TRANSFER_STATUS_RANGES_MAX);
+    send_read_response(gatts_if, param, page, len);
+}
+
+// 读取分块哈希：从 tile_hash_cursor 开始返回一页。有图像等待显示时基准即将改变，返回空表让发送端发送完整图像
+static void send_tile_hash_page(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param) {
+    static uint8_t page[TILE_HASH_PAGE_HEADER + TILE_HASH_PAGE_MAX * 4];
+    uint16_t total = displayed_image != NULL && !image_display_pending() ? tile_map_count(&displayed_tiles) : 0;
+    uint16_t first = tile_hash_cursor < total ? tile_hash_cursor : total;
+    uint16_t count = total - first < TILE_HASH_PAGE_MAX ? total - first : TILE_HASH_PAGE_MAX;
+    uint16_t fields[6] = {first, count, total, TILE_SIZE, displayed_tiles.width, displayed_tiles.height};
+
+    for (int i = 0; i < 6; i++) {
+        put_u16(page + i * 2, fields[i]);
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        put_u32(page + TILE_HASH_PAGE_HEADER + i * 4, displayed_tiles.hashes[first + i]);
+    }
+    send_read_response(gatts_if, param, page, TILE_HASH_PAGE_HEADER + count * 4);
+}
+
+// 服务中的特征，在 ESP_GATTS_ADD_CHAR_EVT 中按顺序依次添加
+static const struct {
+    uint16_t uuid;
+    esp_gatt_perm_t perm;
+    esp_gatt_char_prop_t property;
+    uint16_t* handle;
+} image_chars[] = {
+    {GATTS_CHAR_UUID_IMAGE_DATA, ESP_GATT_PERM_WRITE,
+     ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR, &image_profile_tab.char_handle},
+    {GATTS_CHAR_UUID_TILE_HASH, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+     ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE, &image_profile_tab.hash_handle},
+    {GATTS_CHAR_UUID_STATUS, ESP_GATT_PERM_READ,
+     ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_NOTIFY, &image_profile_tab.status_handle},
+    {GATTS_CHAR_UUID_BULK_DATA, ESP_GATT_PERM_WRITE,
+     ESP_GATT_CHAR_PROP_BIT_WRITE_NR, &image_profile_tab.bulk_handle},
+};
+#define IMAGE_CHAR_COUNT (sizeof(image_chars) / sizeof(image_chars[0]))
+
+// 添加第 index 个特征，全部添加完成后启动服务
+static void add_image_char(int index) {
+    if (index >= IMAGE_CHAR_COUNT) {
+        esp_ble_gatts_start_service(image_profile_tab.service_handle);
+        return;
+    }
+
+    esp_bt_uuid_t char_uuid;
+    char_uuid.len = ESP_UUID_LEN_16;
+    char_uuid.uuid.uuid16 = image_chars[index].uuid;
+
+    esp_ble_gatts_add_char(image_profile_tab.service_handle, &char_uuid,
+                          image_chars[index].perm,
+                          image_chars[index].property,
+                          NULL, NULL);
+}
+
+// 状态特征的客户端配置描述符，发送端写入 0x0001 订阅通知
+static void add_status_cccd(void) {
+    esp_bt_uuid_t descr_uuid;
+    descr_uuid.len = ESP_UUID_LEN_16;
+    descr_uuid.uuid.uuid16 = ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
+
+    esp_ble_gatts_add_char_descr(image_profile_tab.service_handle, &descr_uuid,
+                                 ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, NULL, NULL);
+}
+
+// 连接建立后请求更适合批量传输的链路参数：短连接间隔、最大数据长度和2M PHY
+static void request_bulk_link_params(esp_bd_addr_t remote_bda) {
+    esp_ble_conn_update_params_t conn_params = {0};
+    memcpy(conn_params.bda, remote_bda, sizeof(esp_bd_addr_t));
+    conn_params.min_int = 0x06; // 7.5ms
+    conn_params.max_int = 0x0C; // 15ms
+    conn_params.latency = 0;
+    conn_params.timeout = 400;  // 4s
+    esp_ble_gap_update_conn_params(&conn_params);
+
+    esp_ble_gap_set_pkt_data_len(remote_bda, BLE_MAX_PKT_DATA_LEN);
+#if CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+    esp_ble_gap_set_preferred_phy(remote_bda, ESP_BLE_GAP_NO_PREFER_TRANSMIT_PHY | ESP_BLE_GAP_NO_PREFER_RECEIVE_PHY,
+                                  ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                  ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
 }
 
 // GATT服务回调函数实现
@@ -253,40 +1277,69 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_
         {
             
             image_profile_tab.service_handle = param->create.service_handle;
-
-            esp_bt_uuid_t char_uuid;
-            char_uuid.len = ESP_UUID_LEN_16;
-            char_uuid.uuid.uuid16 = GATTS_CHAR_UUID_IMAGE_DATA;
-
-            esp_ble_gatts_add_char(image_profile_tab.service_handle, &char_uuid,
-                                  ESP_GATT_PERM_WRITE,
-                                  ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR,
-                                  NULL, NULL);
+            add_image_char(0);
         }
         break;
     case ESP_GATTS_ADD_CHAR_EVT:
         {
-            image_profile_tab.char_handle = param->add_char.attr_handle;
-            
-            // 启动服务
-            esp_ble_gatts_start_service(image_profile_tab.service_handle);
+            // 记录句柄后继续添加下一个特征；状态特征先添加描述符
+            int index = 0;
+            while (index < IMAGE_CHAR_COUNT && image_chars[index].uuid != param->add_char.char_uuid.uuid.uuid16) {
+                index++;
+            }
+            if (index < IMAGE_CHAR_COUNT) {
+                *image_chars[index].handle = param->add_char.attr_handle;
+                if (image_chars[index].uuid == GATTS_CHAR_UUID_STATUS) {
+                    add_status_cccd();
+                    break;
+                }
+            }
+            add_image_char(index + 1);
+        }
+        break;
+    case ESP_GATTS_ADD_CHAR_DESCR_EVT:
+        {
+            image_profile_tab.status_cccd_handle = param->add_char_descr.attr_handle;
+            int index = 0;
+            while (index < IMAGE_CHAR_COUNT && image_chars[index].uuid != GATTS_CHAR_UUID_STATUS) {
+                index++;
+            }
+            add_image_char(index + 1);
         }
         break;
     case ESP_GATTS_START_EVT:
         {
         }
         break;
+    case ESP_GATTS_MTU_EVT:
+        gatt_mtu = param->mtu.mtu;
+        break;
+    case ESP_GATTS_READ_EVT:
+        if (param->read.handle == image_profile_tab.hash_handle) {
+            send_tile_hash_page(gatts_if, param);
+        } else if (param->read.handle == image_profile_tab.status_handle) {
+            send_transfer_status(gatts_if, param);
+        } else if (param->read.handle == image_profile_tab.status_cccd_handle) {
+            uint8_t cccd[2] = {status_notify_enabled ? 0x01 : 0x00, 0x00};
+            send_read_response(gatts_if, param, cccd, sizeof(cccd));
+        }
+        break;
     case ESP_GATTS_CONNECT_EVT:
         {   
             image_profile_tab.conn_id = param->connect.conn_id;
-            // 添加设备连接信息显示
-            char connect_msg[64];
-            sprintf(connect_msg, "device connect, connect id: %d", param->connect.conn_id);
+            gatt_mtu = ESP_GATT_DEF_BLE_MTU_SIZE; // 发送端不一定交换 MTU，不能沿用上一个连接的
+            request_bulk_link_params(param->connect.remote_bda);
+            char connect_msg[32];
+            snprintf(connect_msg, sizeof(connect_msg), "connect, id: %d", param->connect.conn_id);
+            ESP_LOGI("GATTS", "%s", connect_msg);
             display_debug_info(connect_msg, false);
         }
         break;
     case ESP_GATTS_DISCONNECT_EVT:
         {
+            prep_len = 0;
+            status_notify_enabled = false;
+            gatt_mtu = ESP_GATT_DEF_BLE_MTU_SIZE;
             char reason_str[32] = "Unknown Reason";
             switch(param->disconnect.reason) {
                 case 0x13: strcpy(reason_str, "User Terminated Connection"); break;
@@ -295,84 +1348,56 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_
                 case 0x08: strcpy(reason_str, "Supervision Timeout"); break;
                 default: sprintf(reason_str, "Code: 0x%x", param->disconnect.reason); break;
             }
-            char info_msg[64];
-            sprintf(info_msg, "disconnect: %s", reason_str);
+            char info_msg[48];
+            snprintf(info_msg, sizeof(info_msg), "disconnect: %s", reason_str);
+            ESP_LOGI("GATTS", "%s", info_msg);
             display_debug_info(info_msg, false);
+            // 保留未完成的传输，重新连接后可以继续
+            rx_session_save();
             // 重新开始广播
             esp_ble_gap_start_advertising(&adv_params);
         }
         break;
     case ESP_GATTS_WRITE_EVT:
+        if (param->write.is_prep) {
+            // 长写入片段：回显片段作为应答，执行写入时再生效
+            esp_gatt_status_t status = ESP_GATT_INVALID_ATTR_LEN;
+            if (param->write.handle == image_profile_tab.char_handle) {
+                status = image_prep_write(param->write.offset, param->write.value, param->write.len);
+            }
+            static esp_gatt_rsp_t prep_rsp;
+            prep_rsp.attr_value.handle = param->write.handle;
+            prep_rsp.attr_value.offset = param->write.offset;
+            prep_rsp.attr_value.len = param->write.len;
+            prep_rsp.attr_value.auth_req = 0;
+            memcpy(prep_rsp.attr_value.value, param->write.value, param->write.len);
+            esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, status, &prep_rsp);
+            break;
+        }
         if (param->write.handle == image_profile_tab.char_handle) {
             // 处理接收到的图像数据
-            display_debug_info("write", false);
-            if (param->write.len > 0) {
-                char info_msg[64];
-                
-                // 第一个数据包包含图像头信息（宽度和高度）
-                if (!image_header_received && param->write.len >= 8) {
-                    // 提取图像宽度和高度信息（前8个字节）
-                    image_width = *(uint32_t*)param->write.value;
-                    image_height = *(uint32_t*)(param->write.value + 4);
-                    
-                    // 显示图像信息
-                    sprintf(info_msg, "recive: %dx%d", image_width, image_height);
-                    display_debug_info(info_msg, false);
-                    
-                    // 重置缓冲区索引
-                    // image_buffer_index = 0;
-                    image_header_received = true;
-                    // esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, ESP_GATT_OK, NULL);
-                    // // 如果数据包中还有图像数据，则复制到缓冲区
-                    // if (param->write.len > 8) {
-                    //     uint32_t data_len = param->write.len - 8;
-                    //     if (image_buffer_index + data_len <= IMAGE_BUFFER_SIZE) {
-                    //         memcpy(image_buffer + image_buffer_index, param->write.value + 8, data_len);
-                    //         image_buffer_index += data_len;
-                            
-                    //         // 显示接收进度
-                    //         uint32_t expected_size = (image_width * image_height) / 2; // 假设4位灰度图，每个像素占4位
-                    //         int percent = (image_buffer_index * 100) / expected_size;
-                    //         sprintf(info_msg, "loading: %d%%", percent > 100 ? 100 : percent);
-                    //         display_debug_info(info_msg, false);
-                    //     } else {
-                    //         display_debug_info("error: data large", false);
-                    //     }
-                    // }
-                } else if (image_header_received) {
-                    // 继续接收图像数据
-                    image_width = *(uint8_t*)param->write.value;
-                    sprintf(info_msg, "recive: %d", image_width);
-                    display_debug_info(info_msg, false);
-                    // esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, ESP_GATT_OK, NULL);
-                    // if (image_buffer_index + param->write.len <= IMAGE_BUFFER_SIZE) {
-                    //     memcpy(image_buffer + image_buffer_index, param->write.value, param->write.len);
-                    //     image_buffer_index += param->write.len;
-                        
-                    //     // 显示接收进度
-                    //     uint32_t expected_size = (image_width * image_height) / 2; // 假设4位灰度图，每个像素占4位
-                    //     int percent = (image_buffer_index * 100) / expected_size;
-                        
-                    //     // 每接收一定量数据更新一次进度显示
-                    //     if (param->write.len >= 1000 || percent >= 100) {
-                    //         sprintf(info_msg, "loading: %d%%", percent > 100 ? 100 : percent);
-                    //         display_debug_info(info_msg, false);
-                    //     }
-                        
-                    //     // 检查是否接收完成
-                    //     if (image_buffer_index >= expected_size) {
-                    //         image_received_complete = true;
-                    //         display_debug_info("done", false);
-                            
-                    //         // 在这里可以调用处理图像的函数
-                    //         process_received_image();
-                    //     }
-                    // } else {
-                    //     display_debug_info("error: max", false);
-                    // }
-                }
-            }
+            image_handle_control(param->write.value, param->write.len);
+        }
+        if (param->write.handle == image_profile_tab.bulk_handle) {
+            // 批量数据通道：与 IMAGE_OP_DATA 相同的重组逻辑，不显示调试信息
+            image_rx_data(param->write.value, param->write.len);
+        }
+        if (param->write.handle == image_profile_tab.hash_handle && param->write.len >= 2) {
+            // 设置下一次读取的起始分块
+            tile_hash_cursor = param->write.value[0] | (param->write.value[1] << 8);
         }
+        if (param->write.need_rsp) {
+            esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, ESP_GATT_OK, NULL);
+        }
+        if (param->write.handle == image_profile_tab.status_cccd_handle && param->write.len >= 2) {
+            // 订阅状态通知后立即推送一次当前状态
+            status_notify_enabled = param->write.value[0] & 0x01;
+            notify_transfer_status(true, true);
+        }
+        break;
+    case ESP_GATTS_EXEC_WRITE_EVT:
+        image_exec_write(param->exec_write.exec_write_flag == ESP_GATT_PREP_WRITE_EXEC);
+        esp_ble_gatts_send_response(gatts_if, param->exec_write.conn_id, param->exec_write.trans_id, ESP_GATT_OK, NULL);
         break;
     default:
         break;
@@ -405,17 +1430,24 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
 // 初始化蓝牙
 static void bluetooth_init(void) {
     esp_err_t ret;
-    
-    // 显示初始化开始信息
-    // display_debug_info("bluetooth init", false);
+    int64_t t = esp_timer_get_time();
 
     // 初始化NVS
     ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        // display_debug_info("NVS init", false);
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
+    t = boot_mark("nvs", t);
+
+    // 接收缓冲区，可能恢复重启前未完成的传输
+    if (!image_slots_init()) {
+        ESP_LOGI("GATTS", "image buffer allocation failed\n");
+    }
+    if (!rx_session_init()) {
+        ESP_LOGI("GATTS", "rx session buffer allocation failed\n");
+    }
+    t = boot_mark("rx buffers", t);
 
     ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT));
 
@@ -423,10 +1455,12 @@ static void bluetooth_init(void) {
     ret = esp_bt_controller_init(&bt_cfg);
 
     ret = esp_bt_controller_enable(ESP_BT_MODE_BLE);
+    t = boot_mark("bt controller", t);
 
     ret = esp_bluedroid_init();
 
     ret = esp_bluedroid_enable();
+    t = boot_mark("bluedroid", t);
 
     ret = esp_ble_gatts_register_callback(gatts_event_handler);
 
@@ -435,40 +1469,100 @@ static void bluetooth_init(void) {
     ret = esp_ble_gatts_app_register(0);
 
     esp_err_t local_mtu_ret = esp_ble_gatt_set_local_mtu(500);
-
+    boot_mark("gatts", t);
 }
 
-void idf_setup() {
+// 显示子系统：面板驱动、电源、温度、残影预算和显示任务
+static void display_init(void) {
+    int64_t t = esp_timer_get_time();
     epd_init(&DEMO_BOARD, &ED060KD1, EPD_LUT_64K);
 
     epd_set_vcom(1560);
+    t = boot_mark("epd init", t);
 
     hl = epd_hl_init(WAVEFORM);
+    boot_mark("framebuffers", t);
 
     epd_set_rotation(EPD_ROT_LANDSCAPE);
 
+    panel_power_init(PANEL_POWER_GPIO, PANEL_IDLE_TIMEOUT_MS);
+    panel_temp_init(TEMP_SAMPLE_INTERVAL_MS);
+    ghost_budget_init(epd_rotated_display_width(), epd_rotated_display_height());
+    glyph_cache_init();
+    if (font_partition_mount() > 0) {
+        text_set_fallback_font(font_partition_find(FALLBACK_FONT_NAME));
+    }
+    if (!display_task_start()) {
+        ESP_LOGE("DISPLAY", "display task start failed");
+    }
+}
+
+// 两路初始化各自的起止时间，汇合后据此打印重叠了多久
+static int64_t ble_init_span[2];
+static int64_t display_init_span[2];
+
+static void display_init_timed(void) {
+    display_init_span[0] = esp_timer_get_time();
+    display_init();
+    display_init_span[1] = esp_timer_get_time();
+}
+
+// 面板初始化任务：在显示核心上运行，与调用核心上的蓝牙初始化并行，完成后通知等待的任务
+static void display_init_task(void* arg) {
+    display_init_timed();
+    xTaskNotifyGive((TaskHandle_t)arg);
+    vTaskDelete(NULL);
+}
+
+static void boot_log_overlap(void) {
+    int64_t begin = ble_init_span[0] > display_init_span[0] ? ble_init_span[0] : display_init_span[0];
+    int64_t end = ble_init_span[1] < display_init_span[1] ? ble_init_span[1] : display_init_span[1];
+    ESP_LOGI("BOOT", "bluetooth %" PRId64 " ms, display %" PRId64 " ms, overlap %" PRId64 " ms",
+             (ble_init_span[1] - ble_init_span[0]) / 1000, (display_init_span[1] - display_init_span[0]) / 1000,
+             end > begin ? (end - begin) / 1000 : 0);
+}
+
+void idf_setup() {
+    int64_t start = boot_mark("setup", 0);
+
+#if FAST_BOOT
+    // 面板不刷新，保持上一张图片
+    panel_content_unknown = true;
+#endif
+
+    // 面板在显示核心上初始化，蓝牙留在当前核心（核心0）：控制器中断分配在调用 esp_bt_controller_init 的核心上，
+    // 与协议栈任务同核。两边同时进行，在显示启动信息之前汇合
+    bool display_async = xTaskCreatePinnedToCore(display_init_task, "display_init", DISPLAY_INIT_TASK_STACK,
+                                                 xTaskGetCurrentTaskHandle(), 5, NULL, DISPLAY_TASK_CORE) == pdPASS;
+
+    ble_init_span[0] = esp_timer_get_time();
+    bluetooth_init();
+    ble_init_span[1] = boot_mark("bluetooth ready", start);
+
+    if (display_async) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    } else {
+        display_init_timed();
+    }
+    boot_mark("display", start);
+    boot_log_overlap();
+
+#if !FAST_BOOT
     heap_caps_print_heap_info(MALLOC_CAP_INTERNAL);
     heap_caps_print_heap_info(MALLOC_CAP_SPIRAM);
     display_debug_info("", true);
 
-    bluetooth_init();
     display_debug_info("bluetooth_init done", false);
 
-    display_debug_info("", true);
-
     display_debug_info("hello world", false);
 
     display_debug_info("lismin", false);
+#endif
 }
 
 void idf_loop() {
-    
-    if (image_received_complete) {
-        process_received_image();
-    }
-    
-    // 添加一些延迟，避免CPU占用过高
-    delay(100);
+    // 图像由蓝牙任务提交给显示任务，这里没有需要轮询的工作
+    delay(1000);
 }
 
 #ifndef ARDUINO_ARCH_ESP32
@@ -0,0 +1,96 @@
+#include "panel_power.h"
+
+#include <driver/gpio.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+
+static const char* TAG = "panel_power";
+
+static int power_gpio = -1;
+static uint32_t idle_timeout_ms = 0;
+static bool power_on = false;
+static bool power_held = false;
+static int64_t power_on_since = 0;  // 本次上电的时间
+static int64_t power_idle_since = 0; // 最近一次释放的时间
+static panel_power_stats_t stats;
+
+static void set_rail(bool on) {
+    int64_t now = esp_timer_get_time();
+    gpio_set_level(power_gpio, on ? 1 : 0);
+    if (on) {
+        power_on_since = now;
+        stats.power_cycles++;
+    } else {
+        stats.on_time_us += now - power_on_since;
+        ESP_LOGI(TAG, "off after %" PRId64 " ms, %" PRIu32 " of %" PRIu32 " updates without power-up",
+                 (now - power_on_since) / 1000, stats.warm_acquires, stats.acquires);
+    }
+    power_on = on;
+}
+
+void panel_power_init(int gpio, uint32_t timeout_ms) {
+    power_gpio = gpio;
+    idle_timeout_ms = timeout_ms;
+    gpio_set_direction(power_gpio, GPIO_MODE_OUTPUT);
+    gpio_set_level(power_gpio, 0);
+    power_on = false;
+    power_held = false;
+}
+
+void panel_power_set_idle_timeout(uint32_t timeout_ms) {
+    idle_timeout_ms = timeout_ms;
+}
+
+bool panel_power_acquire(void) {
+    bool cold = !power_on;
+    stats.acquires++;
+    if (cold) {
+        set_rail(true);
+    } else {
+        stats.warm_acquires++;
+    }
+    power_held = true;
+    return cold;
+}
+
+void panel_power_release(void) {
+    power_held = false;
+    power_idle_since = esp_timer_get_time();
+    if (idle_timeout_ms == 0 && power_on) {
+        set_rail(false);
+    }
+}
+
+int32_t panel_power_idle_remaining_ms(void) {
+    if (!power_on || power_held) {
+        return -1;
+    }
+    int64_t elapsed_ms = (esp_timer_get_time() - power_idle_since) / 1000;
+    return elapsed_ms >= idle_timeout_ms ? 0 : (int32_t)(idle_timeout_ms - elapsed_ms);
+}
+
+bool panel_power_idle(void) {
+    if (panel_power_idle_remaining_ms() == 0) {
+        set_rail(false);
+    }
+    return power_on;
+}
+
+void panel_power_off(void) {
+    power_held = false;
+    if (power_on) {
+        set_rail(false);
+    }
+}
+
+bool panel_power_is_on(void) {
+    return power_on;
+}
+
+void panel_power_get_stats(panel_power_stats_t* out) {
+    *out = stats;
+    if (power_on) {
+        out->on_time_us += esp_timer_get_time() - power_on_since;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// 面板电源管理：连续刷新期间保持供电，空闲超过设定时间后才断电，省掉每次刷新的上电等待。
+// 只在显示任务中调用，不加锁
+typedef struct {
+    uint32_t acquires;      // 刷新前的上电请求次数
+    uint32_t warm_acquires; // 请求时仍在供电，没有重新上电
+    uint32_t power_cycles;  // 实际上电次数
+    int64_t on_time_us;     // 累计供电时间，包含当前这一段
+} panel_power_stats_t;
+
+// 配置控制电源的GPIO和空闲超时，初始为断电
+void panel_power_init(int gpio, uint32_t idle_timeout_ms);
+
+void panel_power_set_idle_timeout(uint32_t idle_timeout_ms);
+
+// 刷新前调用：未供电时上电，并暂停空闲计时。返回 true 表示这次重新上电
+bool panel_power_acquire(void);
+
+// 刷新结束后调用：开始空闲计时
+void panel_power_release(void);
+
+// 距离空闲断电还有多少毫秒；未供电或仍被占用时返回 -1
+int32_t panel_power_idle_remaining_ms(void);
+
+// 空闲时间已到则断电，返回当前是否仍在供电
+bool panel_power_idle(void);
+
+// 立即断电（例如进入深度睡眠前）
+void panel_power_off(void);
+
+bool panel_power_is_on(void);
+
+void panel_power_get_stats(panel_power_stats_t* stats);
@@ -0,0 +1,62 @@
+#include "panel_temp.h"
+
+#include <epdiy.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+static const char* TAG = "panel_temp";
+
+static uint32_t sample_interval_ms = 0;
+static bool sampled = false;
+static bool requested = false;
+static int cached_temperature = 0;
+static int64_t sampled_at = 0;
+static panel_temp_stats_t stats;
+
+static void sample(void) {
+    int temperature = epd_ambient_temperature();
+    if (sampled && temperature != cached_temperature) {
+        ESP_LOGI(TAG, "%d -> %d C", cached_temperature, temperature);
+    }
+    cached_temperature = temperature;
+    sampled = true;
+    requested = false;
+    sampled_at = esp_timer_get_time();
+    stats.samples++;
+}
+
+void panel_temp_init(uint32_t interval_ms) {
+    sample_interval_ms = interval_ms;
+}
+
+int panel_temp_get(void) {
+    if (!sampled) {
+        sample();
+    }
+    stats.lookups++;
+    return cached_temperature;
+}
+
+void panel_temp_request(void) {
+    requested = true;
+}
+
+int32_t panel_temp_due_ms(void) {
+    if (!sampled || requested) {
+        return 0;
+    }
+    int64_t elapsed_ms = (esp_timer_get_time() - sampled_at) / 1000;
+    return elapsed_ms >= sample_interval_ms ? 0 : (int32_t)(sample_interval_ms - elapsed_ms);
+}
+
+bool panel_temp_poll(void) {
+    if (panel_temp_due_ms() > 0) {
+        return false;
+    }
+    sample();
+    return true;
+}
+
+void panel_temp_get_stats(panel_temp_stats_t* out) {
+    *out = stats;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// 缓存的环境温度：刷新时直接使用缓存值选择波形，采样放在显示任务空闲时进行。
+// 只在显示任务中调用，不加锁
+typedef struct {
+    uint32_t samples; // 实际读取传感器的次数
+    uint32_t lookups; // 刷新时取用缓存的次数
+} panel_temp_stats_t;
+
+// 设置定时采样的间隔，第一次取值时同步采样
+void panel_temp_init(uint32_t interval_ms);
+
+// 当前缓存的温度；从未采样过时先同步采样一次
+int panel_temp_get(void);
+
+// 尽快重新采样，例如面板刚上电时
+void panel_temp_request(void);
+
+// 距离下一次采样的毫秒数，0 表示已到期
+int32_t panel_temp_due_ms(void);
+
+// 到期时采样，返回是否读取了传感器
+bool panel_temp_poll(void);
+
+void panel_temp_get_stats(panel_temp_stats_t* stats);
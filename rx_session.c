@@ -0,0 +1,237 @@
+#include "rx_session.h"
+
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <inttypes.h>
+#include <nvs.h>
+#include <string.h>
+
+#define NVS_NAMESPACE "epaper"
+#define NVS_KEY       "rx_session"
+
+#if RX_SESSION_PERSIST
+static const char* TAG = "rx_session";
+
+EXT_RAM_NOINIT_ATTR static uint8_t rx_payload_store[RX_PAYLOAD_MAX];
+#endif
+
+// 会话描述和块位图一起写入NVS
+typedef struct {
+    rx_session_desc_t desc;
+    uint8_t bitmap[(RX_BLOCK_COUNT + 7) / 8];
+} rx_session_record_t;
+
+static rx_session_record_t rx;
+static uint8_t* rx_payload = NULL;
+static bool rx_active = false;
+static uint32_t rx_contig_blocks = 0;
+static uint32_t rx_received = 0;
+
+uint32_t rx_hash(const uint8_t* data, uint32_t len) {
+    uint32_t hash = 0x811C9DC5u;
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 0x01000193u;
+    }
+    return hash;
+}
+
+static uint32_t block_count(void) {
+    return (rx.desc.payload_size + RX_BLOCK_SIZE - 1) / RX_BLOCK_SIZE;
+}
+
+static bool block_received(uint32_t block) {
+    return rx.bitmap[block / 8] & (1 << (block % 8));
+}
+
+static uint32_t block_len(uint32_t block) {
+    uint32_t start = block * RX_BLOCK_SIZE;
+    uint32_t end = start + RX_BLOCK_SIZE;
+    return (end > rx.desc.payload_size ? rx.desc.payload_size : end) - start;
+}
+
+static void mark_block(uint32_t block) {
+    if (!block_received(block)) {
+        rx.bitmap[block / 8] |= 1 << (block % 8);
+        rx_received += block_len(block);
+    }
+}
+
+#if RX_SESSION_PERSIST
+// 根据位图重新计算统计值
+static void recount(void) {
+    rx_received = 0;
+    rx_contig_blocks = 0;
+    uint32_t blocks = block_count();
+    for (uint32_t b = 0; b < blocks; b++) {
+        if (block_received(b)) {
+            rx_received += block_len(b);
+        }
+    }
+    while (rx_contig_blocks < blocks && block_received(rx_contig_blocks)) {
+        rx_contig_blocks++;
+    }
+}
+#endif
+
+static void reset(const rx_session_desc_t* desc) {
+    memset(&rx, 0, sizeof(rx));
+    rx.desc = *desc;
+    rx_contig_blocks = 0;
+    rx_received = 0;
+}
+
+bool rx_session_init(void) {
+#if RX_SESSION_PERSIST
+    rx_payload = rx_payload_store;
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        size_t len = sizeof(rx);
+        if (nvs_get_blob(nvs, NVS_KEY, &rx, &len) == ESP_OK && len == sizeof(rx) &&
+            rx.desc.payload_size <= RX_PAYLOAD_MAX) {
+            rx_active = true;
+            recount();
+            ESP_LOGI(TAG, "restored session %08" PRIx32 ", %" PRIu32 "/%" PRIu32 " bytes",
+                     rx.desc.hash, rx_received, rx.desc.payload_size);
+        }
+        nvs_close(nvs);
+    }
+#else
+    rx_payload = heap_caps_malloc(RX_PAYLOAD_MAX, MALLOC_CAP_SPIRAM);
+#endif
+    return rx_payload != NULL;
+}
+
+bool rx_session_begin(const rx_session_desc_t* desc) {
+    if (rx_active && memcmp(&rx.desc, desc, sizeof(*desc)) == 0) {
+        return true;
+    }
+    reset(desc);
+    rx_active = rx_payload != NULL && desc->payload_size <= RX_PAYLOAD_MAX;
+    return false;
+}
+
+bool rx_session_stage(uint32_t offset, const uint8_t* data, uint32_t len) {
+    if (!rx_active || offset > rx.desc.payload_size || len > rx.desc.payload_size - offset) {
+        return false;
+    }
+    // 已收到的块不覆盖：暂存的长写入可能被取消或因断开而丢弃，不能破坏已确认的数据
+    uint32_t end = offset + len;
+    while (offset < end) {
+        uint32_t block = offset / RX_BLOCK_SIZE;
+        uint32_t block_end = (block + 1) * RX_BLOCK_SIZE;
+        uint32_t n = (block_end < end ? block_end : end) - offset;
+        if (!block_received(block)) {
+            memcpy(rx_payload + offset, data, n);
+        }
+        offset += n;
+        data += n;
+    }
+    return true;
+}
+
+bool rx_session_mark(uint32_t offset, uint32_t len) {
+    if (!rx_active || offset > rx.desc.payload_size || len > rx.desc.payload_size - offset) {
+        return false;
+    }
+
+    // 只标记被完整覆盖的块；最后一块允许不满
+    uint32_t end = offset + len;
+    uint32_t first = (offset + RX_BLOCK_SIZE - 1) / RX_BLOCK_SIZE;
+    uint32_t last = end == rx.desc.payload_size ? block_count() : end / RX_BLOCK_SIZE;
+    for (uint32_t b = first; b < last; b++) {
+        mark_block(b);
+    }
+
+    uint32_t blocks = block_count();
+    while (rx_contig_blocks < blocks && block_received(rx_contig_blocks)) {
+        rx_contig_blocks++;
+    }
+    return true;
+}
+
+bool rx_session_write(uint32_t offset, const uint8_t* data, uint32_t len) {
+    return rx_session_stage(offset, data, len) && rx_session_mark(offset, len);
+}
+
+void rx_session_finish(void) {
+#if RX_SESSION_PERSIST
+    if (rx_active) {
+        nvs_handle_t nvs;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+            nvs_erase_key(nvs, NVS_KEY);
+            nvs_commit(nvs);
+            nvs_close(nvs);
+        }
+    }
+#endif
+    rx_active = false;
+}
+
+void rx_session_save(void) {
+#if RX_SESSION_PERSIST
+    if (!rx_active) {
+        return;
+    }
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        if (nvs_set_blob(nvs, NVS_KEY, &rx, sizeof(rx)) != ESP_OK || nvs_commit(nvs) != ESP_OK) {
+            ESP_LOGW(TAG, "failed to persist session");
+        }
+        nvs_close(nvs);
+    }
+#endif
+}
+
+bool rx_session_active(void) {
+    return rx_active;
+}
+
+const rx_session_desc_t* rx_session_desc(void) {
+    return &rx.desc;
+}
+
+const uint8_t* rx_session_payload(void) {
+    return rx_payload;
+}
+
+uint32_t rx_session_contiguous(void) {
+    uint32_t bytes = rx_contig_blocks * RX_BLOCK_SIZE;
+    return bytes > rx.desc.payload_size ? rx.desc.payload_size : bytes;
+}
+
+uint32_t rx_session_received(void) {
+    return rx_received;
+}
+
+bool rx_session_verify(void) {
+    return rx_active && rx_received == rx.desc.payload_size &&
+           rx_hash(rx_payload, rx.desc.payload_size) == rx.desc.hash;
+}
+
+int rx_session_missing(uint32_t from, uint32_t* starts, uint32_t* lens, int max) {
+    int count = 0;
+    if (!rx_active) {
+        return 0;
+    }
+    uint32_t blocks = block_count();
+    uint32_t b = from / RX_BLOCK_SIZE;
+    while (b < blocks && count < max) {
+        if (block_received(b)) {
+            b++;
+            continue;
+        }
+        uint32_t first = b;
+        while (b < blocks && !block_received(b)) {
+            b++;
+        }
+        starts[count] = first * RX_BLOCK_SIZE;
+        lens[count] = b * RX_BLOCK_SIZE - starts[count];
+        if (starts[count] + lens[count] > rx.desc.payload_size) {
+            lens[count] = rx.desc.payload_size - starts[count];
+        }
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// 接收会话：按内容哈希标识一次传输，以块为单位记录已收到的压缩数据，
+// 断开连接后保留，发送端重新连接后可以只补发缺失的部分
+#define RX_BLOCK_SIZE   32             // 数据包偏移和长度必须按块对齐（最后一包除外）
+#define RX_PAYLOAD_MAX  (300 * 396)    // 与 IMAGE_BUFFER_SIZE 一致
+#define RX_BLOCK_COUNT  ((RX_PAYLOAD_MAX + RX_BLOCK_SIZE - 1) / RX_BLOCK_SIZE)
+
+// 压缩数据放在不初始化的PSRAM段中时，会话可以跨软件重启保留（描述和位图存入NVS）
+#ifdef CONFIG_SPIRAM_ALLOW_NOINIT_SEG_EXTERNAL_MEMORY
+#define RX_SESSION_PERSIST 1
+#else
+#define RX_SESSION_PERSIST 0
+#endif
+
+typedef struct {
+    uint32_t hash;         // 压缩数据的 FNV-1a 哈希，作为会话标识
+    uint32_t payload_size; // 压缩数据长度
+    uint16_t width;
+    uint16_t height;
+    uint16_t tile_count;   // 增量传输的分块数，完整图像为0
+    uint8_t encoding;
+    uint8_t delta;
+} rx_session_desc_t;
+
+// 分配缓冲区，并在启用持久化时从NVS恢复未完成的会话（需在NVS初始化之后调用）
+bool rx_session_init(void);
+
+// 开始一个会话；描述与现有未完成会话一致时保留已接收的数据并返回 true
+bool rx_session_begin(const rx_session_desc_t* desc);
+
+// 写入一段压缩数据，返回 false 表示越界或没有活动会话
+bool rx_session_write(uint32_t offset, const uint8_t* data, uint32_t len);
+
+// 分两步写入：先暂存数据（不计入已接收，也不覆盖已接收的块），确认后再标记。用于 BLE 长写入，执行前可以取消
+bool rx_session_stage(uint32_t offset, const uint8_t* data, uint32_t len);
+bool rx_session_mark(uint32_t offset, uint32_t len);
+
+// 会话结束（完成或出错）后丢弃，已持久化的记录一并删除
+void rx_session_finish(void);
+
+// 断开连接时保存未完成的会话
+void rx_session_save(void);
+
+bool rx_session_active(void);
+const rx_session_desc_t* rx_session_desc(void);
+const uint8_t* rx_session_payload(void);
+
+// 从开头起连续收到的字节数，可以安全地送入解码器
+uint32_t rx_session_contiguous(void);
+
+// 已收到的字节数
+uint32_t rx_session_received(void);
+
+// 校验完整的压缩数据是否与会话哈希一致
+bool rx_session_verify(void);
+
+// 从 from 开始列出缺失的区间 [start, start + len)，返回区间个数
+int rx_session_missing(uint32_t from, uint32_t* starts, uint32_t* lens, int max);
+
+uint32_t rx_hash(const uint8_t* data, uint32_t len);
@@ -0,0 +1,250 @@
+#include "text_layout.h"
+
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#include "text_render.h"
+
+typedef struct {
+    text_layout_t layout;
+    uint32_t last_used;
+    bool valid;
+} cache_entry_t;
+
+static cache_entry_t* cache = NULL; // PSRAM，第一次使用时分配
+static uint32_t use_clock = 0;
+static text_layout_stats_t stats;
+
+typedef struct {
+    int first_glyph;
+    int width; // 不含行尾空格
+} line_t;
+
+// 中日韩文字前后都可以换行
+static bool is_cjk(uint32_t cp) {
+    return (cp >= 0x2E80 && cp <= 0x9FFF) || (cp >= 0xAC00 && cp <= 0xD7AF) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+           (cp >= 0xFF00 && cp <= 0xFFEF);
+}
+
+static bool is_space(uint32_t cp) {
+    return cp == ' ' || cp == '\t' || cp == 0x3000;
+}
+
+// 复制文字，截断时不留下半个 UTF-8 字符
+static void copy_text(char* dst, const char* src) {
+    size_t len = strnlen(src, TEXT_LAYOUT_TEXT_MAX - 1);
+    if (src[len] != 0) {
+        while (len > 0 && ((uint8_t)src[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    memcpy(dst, src, len);
+    dst[len] = 0;
+}
+
+static void layout_text(text_layout_t* layout) {
+    const EpdFont* font = layout->font;
+    int line_height = font->advance_y + layout->line_spacing;
+    int max_lines = 0;
+    if (layout->box.height >= font->advance_y) {
+        max_lines = line_height > 0 ? (layout->box.height - font->advance_y) / line_height + 1 : 1;
+    }
+
+    // 每行的第一个字形，lines[line_count] 总是指向最后一行之后
+    static line_t lines[TEXT_LAYOUT_GLYPHS_MAX + TEXT_LAYOUT_TEXT_MAX + 1];
+    int line_count = 0;
+    layout->glyph_count = 0;
+    layout->truncated = false;
+
+    // 第一遍：横向位置相对行首，x 暂存笔位置
+    int pen = 0;
+    int ink_end = 0;       // 最后一个非空白字形之后的笔位置
+    int break_glyph = -1;  // 最近的换行点（之后第一个字形的序号）
+    int break_pen = 0;
+    int break_width = 0;
+    uint32_t prev = 0;
+    lines[0] = (line_t){0, 0};
+    const char* s = layout->text;
+    uint32_t cp = 1;
+    while (cp != 0) {
+        cp = text_next_codepoint(&s);
+        if (cp == '\n' || cp == 0) {
+            lines[line_count].width = ink_end;
+            line_count++;
+            lines[line_count] = (line_t){layout->glyph_count, 0};
+            pen = ink_end = 0;
+            break_glyph = -1;
+            prev = 0;
+            continue;
+        }
+        const EpdFont* glyph_font = font;
+        const EpdGlyph* glyph = text_find_glyph(&glyph_font, cp, NULL);
+        if (glyph == NULL) {
+            continue;
+        }
+        if (layout->glyph_count == TEXT_LAYOUT_GLYPHS_MAX) {
+            layout->truncated = true;
+            lines[line_count].width = ink_end;
+            line_count++;
+            lines[line_count] = (line_t){layout->glyph_count, 0};
+            break;
+        }
+        bool space = is_space(cp);
+        int index = layout->glyph_count;
+        if (!space && prev != 0 && (is_space(prev) || is_cjk(prev) || is_cjk(cp))) {
+            break_glyph = index;
+            break_pen = pen;
+            break_width = ink_end;
+        }
+        if (!space && pen + glyph->advance_x > layout->box.width && index > lines[line_count].first_glyph) {
+            // 放不下：在最近的换行点换行，没有时从这个字形断开
+            if (break_glyph <= lines[line_count].first_glyph) {
+                break_glyph = index;
+                break_pen = pen;
+                break_width = ink_end;
+            }
+            lines[line_count].width = break_width;
+            line_count++;
+            lines[line_count] = (line_t){break_glyph, 0};
+            for (int i = break_glyph; i < index; i++) {
+                layout->glyphs[i].x -= break_pen;
+            }
+            pen -= break_pen;
+            ink_end = ink_end > break_pen ? ink_end - break_pen : 0;
+            break_glyph = -1;
+        }
+        layout->glyphs[index] = (text_layout_glyph_t){glyph_font, glyph, pen, 0};
+        layout->glyph_count++;
+        pen += glyph->advance_x;
+        if (!space) {
+            ink_end = pen;
+        }
+        prev = cp;
+    }
+
+    // 第二遍：对齐，换成屏幕坐标，丢弃放不下的行
+    if (line_count > max_lines) {
+        layout->truncated = true;
+        line_count = max_lines;
+    }
+    int block_height = line_count > 0 ? (line_count - 1) * line_height + font->advance_y : 0;
+    int top = layout->box.y;
+    if (layout->flags & TEXT_LAYOUT_MIDDLE) {
+        top += (layout->box.height - block_height) / 2;
+    } else if (layout->flags & TEXT_LAYOUT_BOTTOM) {
+        top += layout->box.height - block_height;
+    }
+
+    int x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+    int out = 0;
+    for (int l = 0; l < line_count; l++) {
+        int left = layout->box.x;
+        if (layout->flags & EPD_DRAW_ALIGN_CENTER) {
+            left += (layout->box.width - lines[l].width) / 2;
+        } else if (layout->flags & EPD_DRAW_ALIGN_RIGHT) {
+            left += layout->box.width - lines[l].width;
+        }
+        int baseline = top + l * line_height + font->ascender;
+        for (int i = lines[l].first_glyph; i < lines[l + 1].first_glyph; i++) {
+            text_layout_glyph_t g = layout->glyphs[i];
+            if (g.glyph->width == 0 || g.glyph->height == 0) {
+                continue; // 空白不用画
+            }
+            g.x = left + g.x + g.glyph->left;
+            g.y = baseline - g.glyph->top;
+            layout->glyphs[out++] = g;
+            x0 = g.x < x0 ? g.x : x0;
+            y0 = g.y < y0 ? g.y : y0;
+            x1 = g.x + g.glyph->width > x1 ? g.x + g.glyph->width : x1;
+            y1 = g.y + g.glyph->height > y1 ? g.y + g.glyph->height : y1;
+        }
+    }
+    layout->glyph_count = out;
+    layout->line_count = line_count;
+    layout->bounds = out > 0 ? (EpdRect){x0, y0, x1 - x0, y1 - y0} : (EpdRect){layout->box.x, layout->box.y, 0, 0};
+}
+
+// 完整文字的 FNV-1a 哈希，*len 为其长度
+static uint32_t text_hash(const char* text, uint32_t* len) {
+    uint32_t hash = 0x811C9DC5u;
+    const char* s = text;
+    for (; *s; s++) {
+        hash = (hash ^ (uint8_t)*s) * 0x01000193u;
+    }
+    *len = s - text;
+    return hash;
+}
+
+// 保存的 text 可能截断到更短的 UTF-8 边界，所以按完整文字的长度和哈希比较，再核对保存的部分
+static bool key_matches(const text_layout_t* layout, const EpdFont* font, const char* text, uint32_t len,
+                        uint32_t hash, EpdRect box, int flags, int line_spacing) {
+    return layout->font == font && layout->fallback == text_fallback_font() && layout->flags == flags &&
+           layout->line_spacing == line_spacing && layout->box.x == box.x && layout->box.y == box.y &&
+           layout->box.width == box.width && layout->box.height == box.height && layout->text_len == len &&
+           layout->text_hash == hash && strncmp(layout->text, text, strlen(layout->text)) == 0;
+}
+
+const text_layout_t* text_layout_get(const EpdFont* font, const char* text, EpdRect box, int flags,
+                                     int line_spacing) {
+    if (cache == NULL) {
+        cache = heap_caps_calloc(TEXT_LAYOUT_CACHE_SIZE, sizeof(cache_entry_t), MALLOC_CAP_SPIRAM);
+        if (cache == NULL) {
+            return NULL;
+        }
+    }
+    use_clock++;
+    uint32_t len;
+    uint32_t hash = text_hash(text, &len);
+    cache_entry_t* victim = &cache[0];
+    for (int i = 0; i < TEXT_LAYOUT_CACHE_SIZE; i++) {
+        cache_entry_t* e = &cache[i];
+        if (e->valid && key_matches(&e->layout, font, text, len, hash, box, flags, line_spacing)) {
+            stats.hits++;
+            e->last_used = use_clock;
+            return &e->layout;
+        }
+        if (!e->valid || (victim->valid && e->last_used < victim->last_used)) {
+            victim = e;
+        }
+    }
+
+    stats.misses++;
+    text_layout_t* layout = &victim->layout;
+    layout->font = font;
+    layout->box = box;
+    layout->flags = flags;
+    layout->line_spacing = line_spacing;
+    layout->fallback = text_fallback_font();
+    layout->text_len = len;
+    layout->text_hash = hash;
+    copy_text(layout->text, text);
+    layout_text(layout);
+    victim->valid = true;
+    victim->last_used = use_clock;
+    return layout;
+}
+
+void text_layout_clear(void) {
+    for (int i = 0; cache != NULL && i < TEXT_LAYOUT_CACHE_SIZE; i++) {
+        cache[i].valid = false;
+    }
+}
+
+enum EpdDrawError text_layout_draw(const text_layout_t* layout, uint8_t* framebuffer, const EpdFontProperties* props) {
+    EpdFontProperties defaults = epd_font_properties_default();
+    if (props == NULL) {
+        props = &defaults;
+    }
+    enum EpdDrawError err = EPD_DRAW_SUCCESS;
+    for (int i = 0; i < layout->glyph_count; i++) {
+        const text_layout_glyph_t* g = &layout->glyphs[i];
+        if (text_draw_glyph(g->font, g->glyph, g->x, g->y, framebuffer, props) != EPD_DRAW_SUCCESS) {
+            err = EPD_DRAW_FAILED_ALLOC;
+        }
+    }
+    return err;
+}
+
+void text_layout_get_stats(text_layout_stats_t* out) {
+    *out = stats;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 文字排版：把一段文字按单词换行排进一个矩形，对齐后算出每个字形的位置，结果按
+// (字体, 后备字体, 文字, 矩形, 对齐, 行距) 缓存。重复绘制同样的内容时只剩下逐个字形的合成。只在显示任务中调用
+#define TEXT_LAYOUT_TEXT_MAX   128 // 更长的文字被截断
+#define TEXT_LAYOUT_GLYPHS_MAX 160
+#define TEXT_LAYOUT_CACHE_SIZE 8
+
+// 除 EPD_DRAW_ALIGN_LEFT/CENTER/RIGHT 外的垂直对齐，默认靠上
+#define TEXT_LAYOUT_MIDDLE 0x100
+#define TEXT_LAYOUT_BOTTOM 0x200
+
+typedef struct {
+    const EpdFont* font; // 字形所在的字体，可能是后备字体
+    const EpdGlyph* glyph;
+    int16_t x;           // 位图左上角，屏幕坐标
+    int16_t y;
+} text_layout_glyph_t;
+
+typedef struct {
+    // 缓存键
+    const EpdFont* font;
+    EpdRect box;
+    int flags;
+    int line_spacing;
+    const EpdFont* fallback; // 排版时的后备字体
+    uint32_t text_len;       // 完整文字的长度和哈希，text 中可能只有截断后的部分
+    uint32_t text_hash;
+    char text[TEXT_LAYOUT_TEXT_MAX];
+    // 排版结果
+    int line_count;
+    bool truncated;  // 有放不下的行或字形
+    EpdRect bounds;  // 所有字形位图的外接矩形，没有字形时宽高为0
+    int glyph_count;
+    text_layout_glyph_t glyphs[TEXT_LAYOUT_GLYPHS_MAX];
+} text_layout_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+} text_layout_stats_t;
+
+// 取排版结果，缓存中没有时排版并替换最久未用的一项。行高为 font->advance_y + line_spacing，
+// 超出 box 高度的行被丢弃；内存不足时返回 NULL。返回的指针在下一次调用前有效
+const text_layout_t* text_layout_get(const EpdFont* font, const char* text, EpdRect box, int flags,
+                                     int line_spacing);
+
+// 丢弃所有缓存的排版结果，之前返回的指针随之失效
+void text_layout_clear(void);
+
+// 把排好的字形画进帧缓冲区，使用 props 的颜色、EPD_DRAW_BACKGROUND 和 TEXT_DRAW_MONO
+enum EpdDrawError text_layout_draw(const text_layout_t* layout, uint8_t* framebuffer, const EpdFontProperties* props);
+
+void text_layout_get_stats(text_layout_stats_t* stats);
@@ -0,0 +1,138 @@
+#include "text_render.h"
+
+#include "font_pack.h"
+#include "glyph_blit.h"
+#include "glyph_cache.h"
+
+uint32_t text_next_codepoint(const char** string) {
+    const uint8_t* s = (const uint8_t*)*string;
+    uint32_t cp;
+    int extra;
+    if (s[0] == 0) {
+        return 0;
+    } else if (s[0] < 0x80) {
+        cp = s[0];
+        extra = 0;
+    } else if ((s[0] & 0xE0) == 0xC0) {
+        cp = s[0] & 0x1F;
+        extra = 1;
+    } else if ((s[0] & 0xF0) == 0xE0) {
+        cp = s[0] & 0x0F;
+        extra = 2;
+    } else {
+        cp = s[0] & 0x07;
+        extra = 3;
+    }
+    int i = 1;
+    for (; i <= extra && (s[i] & 0xC0) == 0x80; i++) {
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    *string += i;
+    return cp;
+}
+
+static const EpdFont* fallback_font = NULL;
+
+void text_set_fallback_font(const EpdFont* font) {
+    fallback_font = font;
+}
+
+const EpdFont* text_fallback_font(void) {
+    return fallback_font;
+}
+
+const EpdGlyph* text_find_glyph(const EpdFont** font_inout, uint32_t cp, const EpdFontProperties* props) {
+    const EpdFont* font = *font_inout;
+    const EpdGlyph* glyph = glyph_lookup(font, cp);
+    if (glyph == NULL && fallback_font != NULL && fallback_font != font) {
+        glyph = glyph_lookup(fallback_font, cp);
+        if (glyph != NULL) {
+            *font_inout = fallback_font;
+            return glyph;
+        }
+    }
+    if (glyph == NULL && props != NULL && props->fallback_glyph != 0) {
+        glyph = glyph_lookup(font, props->fallback_glyph);
+    }
+    if (glyph == NULL && font_pack_is_packed(font)) {
+        glyph = font_pack_fallback((const font_pack_t*)font); // 没有指定时用字体包自带的
+    }
+    return glyph;
+}
+
+// 到行尾或字符串结束为止的宽度
+static int line_width(const EpdFont* font, const char* string, const EpdFontProperties* props) {
+    int width = 0;
+    uint32_t cp;
+    while ((cp = text_next_codepoint(&string)) != 0 && cp != '\n') {
+        const EpdFont* glyph_font = font;
+        const EpdGlyph* glyph = text_find_glyph(&glyph_font, cp, props);
+        if (glyph != NULL) {
+            width += glyph->advance_x;
+        }
+    }
+    return width;
+}
+
+int text_string_width(const EpdFont* font, const char* string) {
+    return line_width(font, string, NULL);
+}
+
+enum EpdDrawError text_draw_glyph(const EpdFont* font, const EpdGlyph* glyph, int x, int y, uint8_t* framebuffer,
+                                  const EpdFontProperties* props) {
+    bool mono = props->flags & TEXT_DRAW_MONO;
+    const glyph_blit_colors_t* colors = glyph_blit_colors_for(props, mono);
+    if (mono && font_pack_is_packed(font)) {
+        const uint8_t* bits = font_pack_mono((const font_pack_t*)font, glyph);
+        if (bits != NULL) {
+            glyph_blit_mono(bits, glyph->width, glyph->height, x, y, colors, framebuffer);
+            return EPD_DRAW_SUCCESS;
+        }
+    }
+    const uint8_t* bitmap = glyph_cache_get(font, glyph);
+    if (bitmap == NULL) {
+        return EPD_DRAW_FAILED_ALLOC;
+    }
+    glyph_blit(bitmap, glyph->width, glyph->height, x, y, colors, framebuffer);
+    return EPD_DRAW_SUCCESS;
+}
+
+enum EpdDrawError text_draw_string(const EpdFont* font, const char* string, int* cursor_x, int* cursor_y,
+                                   uint8_t* framebuffer, const EpdFontProperties* props) {
+    EpdFontProperties defaults = epd_font_properties_default();
+    if (props == NULL) {
+        props = &defaults;
+    }
+
+    int line_start = *cursor_x;
+    enum EpdDrawError err = EPD_DRAW_SUCCESS;
+    while (*string) {
+        int x = line_start;
+        if (props->flags & EPD_DRAW_ALIGN_CENTER) {
+            x -= line_width(font, string, props) / 2;
+        } else if (props->flags & EPD_DRAW_ALIGN_RIGHT) {
+            x -= line_width(font, string, props);
+        }
+
+        uint32_t cp;
+        while ((cp = text_next_codepoint(&string)) != 0 && cp != '\n') {
+            const EpdFont* glyph_font = font;
+            const EpdGlyph* glyph = text_find_glyph(&glyph_font, cp, props);
+            if (glyph == NULL) {
+                continue;
+            }
+            if (text_draw_glyph(glyph_font, glyph, x + glyph->left, *cursor_y - glyph->top, framebuffer, props) !=
+                EPD_DRAW_SUCCESS) {
+                err = EPD_DRAW_FAILED_ALLOC;
+            }
+            x += glyph->advance_x;
+        }
+        *cursor_x = x;
+        if (cp == '\n') {
+            *cursor_y += font->advance_y;
+        } else {
+            break;
+        }
+    }
+    return err;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <epdiy.h>
+#include "sdkconfig.h"
+
+// 文字绘制：接口和效果与 epd_write_string 相同，但字形位图来自 glyph_cache，
+// 重复绘制同样的文字不再解压。字体包中没有的字符在未指定 fallback_glyph 时用字体包自带的代替。
+// 只在显示任务中调用
+
+// props->flags 的扩展位：只用前景色和背景色两种灰度绘制，绘制的区域可以用 MODE_DU 快速刷新。
+// 字体包有1bpp变体（font_pack.py --mono）时直接合成变体，否则按阈值二值化4bpp位图
+#define TEXT_DRAW_MONO 0x400
+
+// 字体中没有的字符先在后备字体中查找，例如分区中的中文字体（见 font_partition.h）。NULL 表示不用
+void text_set_fallback_font(const EpdFont* font);
+const EpdFont* text_fallback_font(void);
+
+// 依次在 *font、后备字体中查找码点，再按 props->fallback_glyph 和字体包自带的代替字形；
+// 找到的是后备字体中的字形时 *font 改为后备字体。都没有时返回 NULL
+const EpdGlyph* text_find_glyph(const EpdFont** font, uint32_t codepoint, const EpdFontProperties* props);
+
+// 读取一个 UTF-8 字符并前移 *string，字符串结束时返回0
+uint32_t text_next_codepoint(const char** string);
+
+// 单行文字的宽度（各字形 advance_x 之和）
+int text_string_width(const EpdFont* font, const char* string);
+
+// 在 (x, y)（位图左上角，旋转后的坐标）按 props 绘制一个字形
+enum EpdDrawError text_draw_glyph(const EpdFont* font, const EpdGlyph* glyph, int x, int y, uint8_t* framebuffer,
+                                  const EpdFontProperties* props);
+
+// cursor_y 是基线；按 props->flags 左对齐、居中或右对齐，'\n' 换行。绘制后 cursor_x 位于末尾
+enum EpdDrawError text_draw_string(const EpdFont* font, const char* string, int* cursor_x, int* cursor_y,
+                                   uint8_t* framebuffer, const EpdFontProperties* props);
@@ -0,0 +1,78 @@
+#include "tile_hash.h"
+
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#define FNV_OFFSET 0x811C9DC5u
+#define FNV_PRIME  0x01000193u
+
+bool tile_map_reset(tile_map_t* map, uint16_t width, uint16_t height) {
+    uint16_t cols = (width + TILE_SIZE - 1) / TILE_SIZE;
+    uint16_t rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+    if (map->hashes != NULL && cols * rows == map->cols * map->rows) {
+        map->width = width;
+        map->height = height;
+        map->cols = cols;
+        map->rows = rows;
+        return true;
+    }
+
+    heap_caps_free(map->hashes);
+    memset(map, 0, sizeof(*map));
+    if (cols * rows == 0) {
+        return true;
+    }
+    map->hashes = heap_caps_malloc(cols * rows * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+    if (map->hashes == NULL) {
+        return false;
+    }
+    map->width = width;
+    map->height = height;
+    map->cols = cols;
+    map->rows = rows;
+    return true;
+}
+
+// 分块在图像内的字节范围：行内偏移、每行字节数、行数
+static void tile_extent(const tile_map_t* map, uint16_t col, uint16_t row,
+                        uint32_t* x_byte, uint32_t* row_bytes, uint32_t* y0, uint32_t* lines) {
+    uint32_t x0 = col * TILE_SIZE;
+    uint32_t w = map->width - x0 < TILE_SIZE ? map->width - x0 : TILE_SIZE;
+    *y0 = row * TILE_SIZE;
+    *lines = map->height - *y0 < TILE_SIZE ? map->height - *y0 : TILE_SIZE;
+    *x_byte = x0 / 2;
+    *row_bytes = (w + 1) / 2;
+}
+
+void tile_map_update(tile_map_t* map, const uint8_t* image, uint16_t col, uint16_t row) {
+    uint32_t x_byte, row_bytes, y0, lines;
+    tile_extent(map, col, row, &x_byte, &row_bytes, &y0, &lines);
+
+    uint32_t stride = map->width / 2;
+    uint32_t hash = FNV_OFFSET;
+    for (uint32_t y = 0; y < lines; y++) {
+        const uint8_t* p = image + (y0 + y) * stride + x_byte;
+        for (uint32_t i = 0; i < row_bytes; i++) {
+            hash = (hash ^ p[i]) * FNV_PRIME;
+        }
+    }
+    map->hashes[row * map->cols + col] = hash;
+}
+
+void tile_map_update_all(tile_map_t* map, const uint8_t* image) {
+    for (uint16_t row = 0; row < map->rows; row++) {
+        for (uint16_t col = 0; col < map->cols; col++) {
+            tile_map_update(map, image, col, row);
+        }
+    }
+}
+
+void tile_map_copy_in(const tile_map_t* map, uint8_t* image, uint16_t col, uint16_t row, const uint8_t* tile) {
+    uint32_t x_byte, row_bytes, y0, lines;
+    tile_extent(map, col, row, &x_byte, &row_bytes, &y0, &lines);
+
+    uint32_t stride = map->width / 2;
+    for (uint32_t y = 0; y < lines; y++) {
+        memcpy(image + (y0 + y) * stride + x_byte, tile + y * (TILE_SIZE / 2), row_bytes);
+    }
+}
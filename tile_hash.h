@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 图像按 TILE_SIZE x TILE_SIZE 像素分块，每块记录一个 FNV-1a 哈希
+// （需与 image_converter_sender.py 中的定义保持一致）
+#define TILE_SIZE 32
+#define TILE_BYTES (TILE_SIZE * TILE_SIZE / 2) // 增量记录中每块固定的数据长度
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t cols;
+    uint16_t rows;
+    uint32_t* hashes; // cols * rows 个，按行优先排列
+} tile_map_t;
+
+// 按新的图像尺寸重建分块表；尺寸为0时释放
+bool tile_map_reset(tile_map_t* map, uint16_t width, uint16_t height);
+
+// 重新计算单个分块或全部分块的哈希
+void tile_map_update(tile_map_t* map, const uint8_t* image, uint16_t col, uint16_t row);
+void tile_map_update_all(tile_map_t* map, const uint8_t* image);
+
+// 将一条增量记录中的分块数据写入图像（超出图像边界的部分被忽略）
+void tile_map_copy_in(const tile_map_t* map, uint8_t* image, uint16_t col, uint16_t row, const uint8_t* tile);
+
+static inline uint16_t tile_map_count(const tile_map_t* map) {
+    return map->cols * map->rows;
+}